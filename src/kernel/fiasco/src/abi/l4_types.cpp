@@ -299,6 +299,12 @@ public:
    */
   Mword self_unmap() const { return _raw & 0x80000000; }
 
+  /**
+   * The same flags, but without unmapping from the calling Task.
+   * \return A L4_map_mask that only affects derived mappings.
+   */
+  L4_map_mask children() const { return L4_map_mask(_raw & ~0x80000000UL); }
+
   /**
    * Shall the unmap delete the object if allowed?
    * \return true if the unmap operation shall also delete the kernel
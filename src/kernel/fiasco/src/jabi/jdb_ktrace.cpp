@@ -28,9 +28,38 @@ enum {
   Kern_cnt_schedule          = 9,
   Kern_cnt_iobmap_tlb_flush  = 10,
   Kern_cnt_exc_ipc           = 11,
+  Kern_cnt_drq_ipi_saved     = 12,
+  Kern_cnt_drq_batches       = 13,
+  Kern_cnt_drq_batch_items   = 14,
+  Kern_cnt_fpu_trap          = 15,
+  Kern_cnt_fpu_eager         = 16,
+  Kern_cnt_fpu_eager_drop    = 17,
   Kern_cnt_max
 };
 
+/**
+ * Latency histograms kept with CONFIG_JDB_LATENCY_HIST. Bucket 0 counts
+ * samples below 1 << Lat_hist_shift cycle-counter ticks, bucket n > 0
+ * samples in [1 << (n + Lat_hist_shift - 1), 1 << (n + Lat_hist_shift)),
+ * the last bucket also everything above. CPU n < Lat_hist_cpus uses slot
+ * n, the histograms of further CPUs are in the streaming area, see
+ * Tbuf_stream_status.
+ */
+enum {
+  Lat_hist_spin_wait         = 0,
+  Lat_hist_spin_hold         = 1,
+  Lat_hist_lock_wait         = 2,
+  Lat_hist_lock_hold         = 3,
+  Lat_hist_ipc_call          = 4,
+  Lat_hist_page_fault        = 5,
+  Lat_hist_context_switch    = 6,
+  Lat_hist_max,
+
+  Lat_hist_buckets           = 24,
+  Lat_hist_shift             = 4,
+  Lat_hist_cpus              = 4,
+};
+
 struct Tracebuffer_status_window
 {
   Address    tracebuffer;
@@ -49,4 +78,39 @@ struct Tracebuffer_status
   Unsigned32 scaler_ns_to_tsc;
 
   Unsigned32 kerncnts[Kern_cnt_max];
+
+  Unsigned32 lat_hist[Lat_hist_cpus][Lat_hist_max][Lat_hist_buckets];
+};
+
+enum { Tbuf_stream_cpus = 32 };
+
+/**
+ * Trace stream of one CPU. The ring starts offset bytes from the start of
+ * the streaming area and holds entries trace buffer entries, 0 if the CPU
+ * does not stream. head counts the committed entries, entry n is in slot
+ * n % entries. Each CPU writes its own cache line only.
+ */
+struct Tbuf_stream_cpu
+{
+  Mword head;
+  Mword entries;
+  Mword offset;
+  Mword _pad[5];
+};
+
+/**
+ * First page of the streaming area that the consumer task maps read-only,
+ * followed by the rings. The latency histograms of CPU Lat_hist_cpus + n
+ * are at slot n of an array like Tracebuffer_status::lat_hist,
+ * lat_hist_offset bytes from the start of the area, for lat_hist_cpus
+ * CPUs. lat_hist_cpus is 0 without CONFIG_JDB_LATENCY_HIST.
+ */
+struct Tbuf_stream_status
+{
+  Mword           entry_size;
+  Mword           cpus;
+  Mword           lat_hist_offset;
+  Mword           lat_hist_cpus;
+  Mword           _pad[4];
+  Tbuf_stream_cpu cpu[Tbuf_stream_cpus];
 };
@@ -26,6 +26,15 @@ Jdb_counters::show()
   putchar('\n');
   for (unsigned i=0; i<Kern_cnt_max; i++)
     printf("  %-25s%10ld\n", Kern_cnt::get_str(i), *Kern_cnt::get_ctr(i));
+
+  Unsigned32 const *cnt = Jdb_tbuf::status()->kerncnts;
+  Unsigned32 batches = cnt[Kern_cnt_drq_batches];
+  if (batches)
+    {
+      Unsigned32 items = cnt[Kern_cnt_drq_batch_items];
+      printf("  %-25s%7u.%02u\n", "DRQ avg. batch size",
+             items / batches, (items % batches) * 100 / batches);
+    }
   putchar('\n');
 }
 
@@ -1,4 +1,4 @@
-IMPLEMENTATION [tickless_idle]:
+IMPLEMENTATION [tickless_idle || tickless]:
 
 #include <climits>
 #include <cstring>
@@ -34,6 +34,7 @@ Jdb_idle_stats::action(int, void *&, char const *&, int &)
              Kernel_thread::_idle_counter.cpu(i),
              Kernel_thread::_deep_idle_counter.cpu(i));
     }
+  show_suppressed_ticks();
   return NOTHING;
 }
 
@@ -54,3 +55,27 @@ Jdb_idle_stats::num_cmds() const
 { return 1; }
 
 static Jdb_idle_stats jdb_idle_stats INIT_PRIORITY(JDB_MODULE_INIT_PRIO);
+
+// ------------------------------------------------------------------------
+IMPLEMENTATION [tickless_idle && !tickless]:
+
+PRIVATE static inline
+void
+Jdb_idle_stats::show_suppressed_ticks()
+{}
+
+// ------------------------------------------------------------------------
+IMPLEMENTATION [tickless]:
+
+#include "cpu.h"
+#include "timer.h"
+
+PRIVATE static
+void
+Jdb_idle_stats::show_suppressed_ticks()
+{
+  for (Cpu_number i = Cpu_number::first(); i < Config::max_num_cpus(); ++i)
+    if (Cpu::online(i))
+      printf("CPU[%2u]: %llu ticks suppressed\n",
+             cxx::int_value<Cpu_number>(i), Timer::suppressed_ticks(i));
+}
@@ -12,6 +12,12 @@ private:
 //---------------------------------------------------------------------------
 IMPLEMENTATION:
 
+#include <cstring>
+#include "buddy_alloc.h"
+#include "kmem_alloc.h"
+#include "mem_layout.h"
+#include "mem_space.h"
+
 static Jdb_kern_info_bench k_a INIT_PRIORITY(JDB_MODULE_INIT_PRIO+1);
 
 PUBLIC
@@ -26,9 +32,79 @@ void
 Jdb_kern_info_bench::show()
 {
   do_mp_benchmark();
+  do_copy_remap_benchmark();
   show_arch();
 }
 
+/**
+ * Compare moving a buffer by copying with moving it by page-table
+ * remapping, the two ways of transferring bulk data with IPC.
+ * Remapping is measured without the mapping database, i.e. it is a
+ * lower bound for a map item of the same size.
+ */
+PRIVATE static
+void
+Jdb_kern_info_bench::do_copy_remap_benchmark()
+{
+  enum
+  {
+    /// Largest buffer, one Kmem_alloc block at most
+    Max_order = 17,
+    Runs2     = 2,
+  };
+
+  static_assert((1UL << Max_order) <= Kmem_alloc::Alloc::Max_size,
+                "benchmark buffers exceed the largest kernel memory block");
+
+  Kmem_alloc *a = Kmem_alloc::allocator();
+  char *src = (char *)a->alloc(Max_order);
+  char *dst = (char *)a->alloc(Max_order);
+  if (!src || !dst)
+    {
+      printf("Copy/remap: out of kernel memory\n");
+      if (src)
+        a->free(Max_order, src);
+      if (dst)
+        a->free(Max_order, dst);
+      return;
+    }
+
+  // unused part of the user half of the kernel's address space
+  Mem_space *ks = Mem_space::kernel_space();
+  Mem_space::Vaddr const win
+    = cxx::mask_lsb(Virt_addr(Mem_layout::User_max / 2),
+                    Mem_space::Page_order(Max_order));
+  Mem_space::Page_order const po(Config::PAGE_SHIFT);
+
+  printf("Copy vs. remap:\n");
+  for (unsigned o = Config::PAGE_SHIFT; o <= Max_order; o += 2)
+    {
+      unsigned long const size = 1UL << o;
+      Unsigned64 time = get_time_now();
+      for (unsigned i = 0; i < (1 << Runs2); ++i)
+        memcpy(dst, src, size);
+      Unsigned64 copy = (get_time_now() - time) >> Runs2;
+
+      time = get_time_now();
+      for (unsigned i = 0; i < (1 << Runs2); ++i)
+        {
+          for (unsigned long offs = 0; offs < size; offs += Config::PAGE_SIZE)
+            ks->v_insert(Mem_space::Phys_addr(a->to_phys(src + offs)),
+                         win + Virt_size(offs), po,
+                         Mem_space::Attr(L4_fpage::Rights::URW()));
+          for (unsigned long offs = 0; offs < size; offs += Config::PAGE_SIZE)
+            ks->v_delete(win + Virt_size(offs), po, L4_fpage::Rights::FULL());
+          ks->tlb_flush(true);
+        }
+      Unsigned64 remap = (get_time_now() - time) >> Runs2;
+
+      printf("%8lu bytes: copy %10lld  remap %10lld\n", size, copy, remap);
+    }
+
+  a->free(Max_order, src);
+  a->free(Max_order, dst);
+}
+
 //---------------------------------------------------------------------------
 IMPLEMENTATION [!mp]:
 
@@ -1,5 +1,9 @@
 IMPLEMENTATION:
 
+#include <cstdio>
+
+#include "buddy_alloc.h"
+#include "cpu.h"
 #include "static_init.h"
 #include "jdb_kern_info.h"
 #include "kmem_alloc.h"
@@ -28,6 +32,99 @@ Jdb_kern_info_memory::show()
   for (Iter alloc = Kmem_slab::reap_list.begin();
        alloc != Kmem_slab::reap_list.end(); ++alloc)
     alloc->debug_dump();
+
+  show_magazines();
+  show_hot_pages();
+  show_fragmentation();
+}
+
+/**
+ * Per-CPU magazine hit rates of all slab caches.
+ */
+PRIVATE static
+void
+Jdb_kern_info_memory::show_magazines()
+{
+  typedef Kmem_slab::Reap_list::Const_iterator Iter;
+
+  printf("\nSlab magazines (hit rate %% / objects cached per CPU):\n");
+  for (Iter alloc = Kmem_slab::reap_list.begin();
+       alloc != Kmem_slab::reap_list.end(); ++alloc)
+    {
+      printf("%-14s depot=%2u", alloc->name(), alloc->depot_magazines());
+      for (Cpu_number i = Cpu_number::first(); i < Config::max_num_cpus(); ++i)
+        {
+          if (!Cpu::online(i))
+            continue;
+
+          Slab_cache::Mag_stats s = alloc->mag_stats(i);
+          unsigned long total = s.hits + s.misses;
+          if (total)
+            printf(" %3lu/%-2u", s.hits * 100 / total, s.rounds);
+          else
+            printf("   -/%-2u", s.rounds);
+        }
+      putchar('\n');
+    }
+}
+
+/**
+ * Per-CPU hot page list hit rates of the kernel allocator.
+ */
+PRIVATE static
+void
+Jdb_kern_info_memory::show_hot_pages()
+{
+  printf("\nKmem hot pages (hit rate %% / blocks cached per CPU):\n");
+  for (unsigned c = 0; c < Kmem_alloc::Hot_classes; ++c)
+    {
+      printf("%2u pages     ", 1U << c);
+      for (Cpu_number i = Cpu_number::first(); i < Config::max_num_cpus(); ++i)
+        {
+          if (!Cpu::online(i))
+            continue;
+
+          Kmem_alloc::Hot_stats s = Kmem_alloc::hot_stats(i, c);
+          unsigned long total = s.hits + s.misses;
+          if (total)
+            printf(" %3lu/%-2u", s.hits * 100 / total, s.count);
+          else
+            printf("   -/%-2u", s.count);
+        }
+      putchar('\n');
+    }
+  printf("large pool: %u of %u blocks of %uKB, used %lu times\n",
+         Kmem_alloc::large_pool_blocks(),
+         (unsigned)Kmem_alloc::Large_pool_blocks,
+         (unsigned)Kmem_alloc::Alloc::Max_size / 1024,
+         Kmem_alloc::large_pool_used());
 }
 
+/**
+ * Free buddy blocks per size and, for each size, the share of free memory
+ * that sits in smaller blocks and cannot serve an allocation of that size.
+ */
+PRIVATE static
+void
+Jdb_kern_info_memory::show_fragmentation()
+{
+  typedef Kmem_alloc::Alloc Alloc;
+  unsigned long blocks[Alloc::Num_sizes];
+  unsigned long total = 0;
 
+  for (unsigned i = 0; i < Alloc::Num_sizes; ++i)
+    {
+      blocks[i] = Kmem_alloc::free_blocks(i);
+      total += blocks[i] * ((unsigned long)Alloc::Min_size << i);
+    }
+
+  printf("\nKmem fragmentation (free blocks / unusable free memory):\n");
+  unsigned long smaller = 0;
+  for (unsigned i = 0; i < Alloc::Num_sizes; ++i)
+    {
+      printf("  %4luKB %6lu %3lu%%\n",
+             ((unsigned long)Alloc::Min_size << i) / 1024, blocks[i],
+             total ? smaller * 100 / total : 0UL);
+      smaller += blocks[i] * ((unsigned long)Alloc::Min_size << i);
+    }
+}
@@ -53,6 +53,7 @@ protected:
     Op_switch_log       = 4,
     Op_get_name         = 5,
     Op_query_log_name   = 6,
+    Op_tbuf_stream      = 7,
   };
 };
 
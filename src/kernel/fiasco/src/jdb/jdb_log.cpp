@@ -10,6 +10,7 @@ IMPLEMENTATION:
 #include "jdb_kobject.h"
 #include "jdb_list.h"
 #include "jdb_screen.h"
+#include "jdb_tbuf.h"
 #include "kernel_console.h"
 #include "keycodes.h"
 #include "mem_unit.h"
@@ -41,7 +42,7 @@ public:
 
 PUBLIC
 bool
-Jdb_log_list_hdl::invoke(Kobject_common *, Syscall_frame *f, Utcb *utcb)
+Jdb_log_list_hdl::invoke(Kobject_common *o, Syscall_frame *f, Utcb *utcb)
 {
   switch (utcb->values[0])
     {
@@ -109,6 +110,24 @@ Jdb_log_list_hdl::invoke(Kobject_common *, Syscall_frame *f, Utcb *utcb)
             f->tag(Kobject_iface::commit_result(0));
             return true;
           }
+      case Op_tbuf_stream:
+          {
+            // the streaming area can only be mapped into the caller's task
+            Task *t = Kobject::dcast<Task*>(o);
+            if (f->tag().words() < 3 || !t
+                || static_cast<Space *>(t) != current()->space())
+              {
+                f->tag(Kobject_iface::commit_result(-L4_err::EInval));
+                return true;
+              }
+
+            Address size = 0;
+            int r = Jdb_tbuf::stream(t, utcb->values[1], utcb->values[2],
+                                     &size);
+            utcb->values[0] = size;
+            f->tag(Kobject_iface::commit_result(r, 1));
+            return true;
+          }
     }
 
   return false;
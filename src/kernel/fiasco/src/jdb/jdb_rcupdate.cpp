@@ -33,6 +33,16 @@ Jdb_rcupdate::print_batch(Rcu_batch const &b)
   printf("#%ld", b._b);
 }
 
+PRIVATE static
+unsigned long
+Jdb_rcupdate::length(Rcu_list const &l)
+{
+  unsigned long n = 0;
+  for (Rcu_list::Const_iterator i = l.begin(); i != l.end(); ++i)
+    ++n;
+  return n;
+}
+
 PUBLIC
 Jdb_module::Action_code
 Jdb_rcupdate::action(int cmd, void *&, char const *&, int &)
@@ -52,6 +62,9 @@ Jdb_rcupdate::action(int cmd, void *&, char const *&, int &)
       printf("  active cpus=");
       Jdb::cpu_mask_print(Rcu::_rcu._active_cpus);
       puts("");
+      printf("  expedited batch=");
+      print_batch(Rcu::_rcu._expedited);
+      printf(" (%lu expedited grace periods)\n", Rcu::_rcu._expedite_cnt);
 
       for (Cpu_number i = Cpu_number::first(); i < Config::max_num_cpus(); ++i)
 	{
@@ -66,9 +79,13 @@ Jdb_rcupdate::action(int cmd, void *&, char const *&, int &)
 	  printf("    wait for quiescent state: %s\n", d->_pending?"yes":"no");
 	  printf("    batch=");
 	  print_batch(d->_batch); puts("");
-	  printf("    next list:    h=%p len=%ld\n", d->_n.front(), d->_len);
-	  printf("    current list: h=%p \n", d->_c.front());
-	  printf("    done list:    h=%p\n", d->_d.front());
+	  printf("    callbacks: %ld\n", d->_len);
+	  printf("    next list:    h=%p n=%lu\n", d->_n.front(), length(d->_n));
+	  printf("    ready list:   h=%p n=%lu batch=", d->_r.front(),
+	         length(d->_r));
+	  print_batch(d->_r_batch); puts("");
+	  printf("    current list: h=%p n=%lu\n", d->_c.front(), length(d->_c));
+	  printf("    done list:    h=%p n=%lu\n", d->_d.front(), length(d->_d));
 	}
     }
   return NOTHING;
@@ -30,9 +30,18 @@ Jdb_cpu::Jdb_cpu()
 
 PUBLIC
 bool
-Jdb_cpu::show_kobject(Kobject_common *, int )
+Jdb_cpu::show_kobject(Kobject_common *, int lvl)
 {
-  return true;
+  if (!show_servers())
+    return true;
+
+  if (lvl)
+    {
+      Jdb::getchar();
+      return true;
+    }
+
+  return false;
 }
 
 PUBLIC
@@ -43,3 +52,78 @@ Jdb_cpu::kobject_type() const
 }
 
 static Jdb_cpu jdb_cpu INIT_PRIORITY(JDB_MODULE_INIT_PRIO);
+
+// --------------------------------------------------------------------------
+IMPLEMENTATION [!sched_fp_edf]:
+
+PRIVATE static inline
+bool
+Jdb_cpu::show_servers()
+{ return false; }
+
+// --------------------------------------------------------------------------
+IMPLEMENTATION [sched_fp_edf]:
+
+#include "div32.h"
+#include "globals.h"
+#include "kip.h"
+#include "sched_context.h"
+#include "thread_object.h"
+#include "timeout.h"
+
+/**
+ * Show the budget consumption of all constant bandwidth servers.
+ */
+PRIVATE static
+bool
+Jdb_cpu::show_servers()
+{
+  Unsigned64 now = Kip::k()->clock;
+  Mword reserved[Config::Max_num_cpus];
+  memset(reserved, 0, sizeof(reserved));
+
+  Jdb::clear_screen();
+  printf("CBS servers, times in %cs\n\n"
+         "   thread cpu    budget    period      used  deadline  state"
+         "      throttled\n", Config::char_micro);
+
+  for (Kobject_dbg::Iterator o = Kobject_dbg::begin(); o != Kobject_dbg::end(); ++o)
+    {
+      Thread *t = Kobject::dcast<Thread_object*>(Kobject::from_dbg(*o));
+      if (!t)
+        continue;
+
+      Sched_context *sc = t->sched_context();
+      if (sc->type() != Sched_context::Edf)
+        continue;
+
+      Cpu_number cpu = t->home_cpu();
+      Unsigned64 left = sc->_left;
+      if (Sched_context::rq.cpu(cpu).current_sched() == sc)
+        {
+          // the budget of the running server is in its timeslice timeout
+          Signed64 l = timeslice_timeout.cpu(cpu)->get_timeout(now);
+          left = l > 0 ? l : 0;
+        }
+
+      unsigned c = cxx::int_value<Cpu_number>(cpu);
+      if (c < Config::Max_num_cpus)
+        reserved[c] += div32(Unsigned64(sc->_budget) * 1000, sc->_period);
+
+      printf("%9lx %3u %9llu %9llu %9llu %9lld  %-9s %9lu\n",
+             t->dbg_info()->dbg_id(), c,
+             sc->_budget, sc->_period,
+             sc->_budget > left ? sc->_budget - left : 0ULL,
+             (Signed64)(sc->_dl - now),
+             !sc->in_ready_list() ? "blocked"
+             : sc->_throttled ? "throttled" : "ready",
+             sc->_throttle_cnt);
+    }
+
+  printf("\nreserved bandwidth per CPU:");
+  for (unsigned c = 0; c < Config::Max_num_cpus; ++c)
+    if (reserved[c])
+      printf(" %u:%lu.%lu%%", c, reserved[c] / 10, reserved[c] % 10);
+  putchar('\n');
+  return true;
+}
@@ -2,12 +2,14 @@ INTERFACE:
 
 #include "jdb_ktrace.h"
 #include "l4_types.h"
+#include "per_cpu_data.h"
 #include "std_macros.h"
 #include "tb_entry.h"
 #include "spin_lock.h"
 
 class Context;
 class Log_event;
+class Task;
 struct Tracebuffer_status;
 
 class Jdb_tbuf
@@ -32,6 +34,27 @@ protected:
   static Mword		_count_mask2;
   static Address        _size;		// size of memory area for tbuffer
   static Spin_lock<>    _lock;
+
+  enum
+  {
+    /// Bytes per stream ring, at most the largest Kmem_alloc block
+    Stream_ring_size = 128 << 10,
+    Stream_entries = Stream_ring_size / Tb_entry::Tb_entry_size,
+  };
+
+  /// Trace stream of a CPU, only used by this CPU with the CPU lock held.
+  struct Stream
+  {
+    Tb_entry_union *ring;
+    Mword next;
+    Tbuf_stream_cpu *head;
+    bool open;  ///< new_entry() used the stream, commit_entry() pending
+  };
+
+  static Per_cpu<Stream> _stream;
+  static Tbuf_stream_status *_stream_status;
+  static Address _stream_size;
+  static bool _streaming;
 };
 
 #ifdef CONFIG_JDB_LOGGING
@@ -174,11 +197,17 @@ protected:
 IMPLEMENTATION:
 
 #include "config.h"
+#include "cpu.h"
 #include "cpu_lock.h"
 #include "initcalls.h"
+#include "buddy_alloc.h"
+#include "kmem_alloc.h"
+#include "lat_hist.h"
 #include "lock_guard.h"
+#include "mem.h"
 #include "mem_layout.h"
 #include "std_macros.h"
+#include "task.h"
 
 Tb_entry_union *Jdb_tbuf::_tbuf_act;
 Tb_entry_union *Jdb_tbuf::_tbuf_max;
@@ -190,6 +219,10 @@ Mword Jdb_tbuf::_count_mask1;
 Mword Jdb_tbuf::_count_mask2;
 Address Jdb_tbuf::_size;
 Spin_lock<> Jdb_tbuf::_lock;
+DEFINE_PER_CPU Per_cpu<Jdb_tbuf::Stream> Jdb_tbuf::_stream;
+Tbuf_stream_status *Jdb_tbuf::_stream_status;
+Address Jdb_tbuf::_stream_size;
+bool Jdb_tbuf::_streaming;
 
 static void direct_log_dummy(Tb_entry*, const char*)
 {}
@@ -231,12 +264,23 @@ Jdb_tbuf::clear_tbuf()
   _entries = 0;
 }
 
-/** Return pointer to new tracebuffer entry. */
+/** Return pointer to new tracebuffer entry.
+ * While streaming, the entry goes to the ring of the current CPU without
+ * taking the global lock, the CPU lock must be held until commit_entry().
+ * Entries are numbered per CPU then. */
 PUBLIC static
 Tb_entry*
 Jdb_tbuf::new_entry()
 {
   Tb_entry *tb;
+  if (EXPECT_FALSE(_streaming) && _stream.current().ring)
+    {
+      Stream &s = _stream.current();
+      tb = s.ring + (s.next & (Stream_entries - 1));
+      tb->number(++s.next);
+      s.open = true;
+    }
+  else
   {
     auto guard = lock_guard(_lock);
 
@@ -273,6 +317,16 @@ PUBLIC static
 void
 Jdb_tbuf::commit_entry()
 {
+  if (EXPECT_FALSE(_stream_status != 0) && _stream.current().open)
+    {
+      // publish the entry to the consumer after its contents
+      Stream &s = _stream.current();
+      s.open = false;
+      Mem::mp_wmb();
+      write_now(&s.head->head, s.next);
+      return;
+    }
+
   if (EXPECT_FALSE((_number & _count_mask2) == 0))
     {
       if (_number & _count_mask1)
@@ -570,3 +624,144 @@ Jdb_tbuf::disable_filter()
 {
   _filter_enabled = 0;
 }
+
+/**
+ * Allocate the trace streams of all online CPUs, once. CPUs without a
+ * stream keep logging into the global buffer.
+ * \pre _lock held
+ */
+PRIVATE static
+bool
+Jdb_tbuf::stream_alloc()
+{
+  static_assert(Stream_ring_size <= Kmem_alloc::Alloc::Max_size,
+                "stream ring exceeds the largest kernel memory block");
+  static_assert(!(Stream_entries & (Stream_entries - 1)),
+                "stream entries must be a power of two");
+
+  if (_stream_status)
+    return true;
+
+  Kmem_alloc *a = Kmem_alloc::allocator();
+  Tbuf_stream_status *st
+    = (Tbuf_stream_status *)a->unaligned_alloc(Config::PAGE_SIZE);
+  if (!st)
+    return false;
+
+  memset(st, 0, Config::PAGE_SIZE);
+  st->entry_size = sizeof(Tb_entry_union);
+
+  Address const ring_size = Stream_ring_size;
+  Address offset = Config::PAGE_SIZE;
+
+  Address hist_size;
+  if (Lat_hist::rest(&hist_size, &st->lat_hist_cpus))
+    {
+      st->lat_hist_offset = offset;
+      offset += hist_size;
+    }
+  for (Cpu_number c = Cpu_number::first();
+       c < Config::max_num_cpus()
+       && cxx::int_value<Cpu_number>(c) < Tbuf_stream_cpus;
+       ++c)
+    {
+      if (!Cpu::online(c))
+        continue;
+
+      Tb_entry_union *r = (Tb_entry_union *)a->unaligned_alloc(ring_size);
+      if (!r)
+        break;
+
+      unsigned i = cxx::int_value<Cpu_number>(c);
+      Stream &s = _stream.cpu(c);
+      s.ring = r;
+      s.next = 0;
+      s.open = false;
+      s.head = &st->cpu[i];
+      s.head->entries = Stream_entries;
+      s.head->offset = offset;
+      st->cpus = i + 1;
+      offset += ring_size;
+    }
+
+  if (!st->cpus)
+    {
+      a->unaligned_free(Config::PAGE_SIZE, st);
+      return false;
+    }
+
+  _stream_size = offset;
+  Mem::mp_wmb();
+  _stream_status = st;
+  return true;
+}
+
+/// Kernel address of the streaming area at offset.
+PRIVATE static
+Address
+Jdb_tbuf::stream_kern_addr(Address offset)
+{
+  if (offset < Config::PAGE_SIZE)
+    return (Address)_stream_status + offset;
+
+  Address hist_size;
+  Mword hist_cpus;
+  if (void *h = Lat_hist::rest(&hist_size, &hist_cpus))
+    {
+      Address o = offset - _stream_status->lat_hist_offset;
+      if (offset >= _stream_status->lat_hist_offset && o < hist_size)
+        return (Address)h + o;
+    }
+
+  Address const ring_size = Stream_ring_size;
+  for (Cpu_number c = Cpu_number::first(); c < Config::max_num_cpus(); ++c)
+    {
+      Stream const &s = _stream.cpu(c);
+      if (s.ring && offset >= s.head->offset
+          && offset < s.head->offset + ring_size)
+        return (Address)s.ring + offset - s.head->offset;
+    }
+
+  return 0;
+}
+
+/**
+ * Switch the per-CPU trace streams on or off, and map the streaming area
+ * read-only into task t at va unless va is 0.
+ * \return 0 or a negative error code, the size of the area in size
+ */
+PUBLIC static
+int
+Jdb_tbuf::stream(Task *t, bool on, Address va, Address *size)
+{
+  auto guard = lock_guard(_lock);
+
+  if (!stream_alloc())
+    return -L4_err::ENomem;
+
+  *size = _stream_size;
+  if (va)
+    {
+      if (va & (Config::PAGE_SIZE - 1))
+        return -L4_err::EInval;
+
+      for (Address o = 0; o < _stream_size; o += Config::PAGE_SIZE)
+        {
+          Mem_space::Phys_addr pa(t->pmem_to_phys(stream_kern_addr(o)));
+          Mem_space::Status res =
+            static_cast<Mem_space *>(t)->v_insert(pa, Virt_addr(va + o),
+                Mem_space::Page_order(Config::PAGE_SHIFT),
+                Mem_space::Attr(L4_fpage::Rights::UR()));
+
+          switch (res)
+            {
+            case Mem_space::Insert_err_nomem:  return -L4_err::ENomem;
+            case Mem_space::Insert_err_exists: return -L4_err::EExists;
+            default: break;
+            }
+        }
+    }
+
+  _streaming = on;
+  return 0;
+}
@@ -21,6 +21,7 @@ IMPLEMENTATION:
 #include "cpu.h"
 #include "jdb_ktrace.h"
 #include "koptions.h"
+#include "lat_hist.h"
 #include "mem_layout.h"
 #include "vmem_alloc.h"
 
@@ -84,6 +85,10 @@ void Jdb_tbuf_init::init()
       status()->scaler_tsc_to_us = Cpu::boot_cpu()->get_scaler_tsc_to_us();
       status()->scaler_ns_to_tsc = Cpu::boot_cpu()->get_scaler_ns_to_tsc();
 
+      static_assert(sizeof(Tracebuffer_status) <= Config::PAGE_SIZE,
+                    "tbuf status does not fit into one page");
+      Lat_hist::enable(status());
+
       _tbuf_max    = buffer() + max_entries();
       _count_mask1 =  max_entries()    - 1;
       _count_mask2 = (max_entries())/2 - 1;
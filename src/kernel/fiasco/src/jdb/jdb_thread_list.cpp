@@ -245,7 +245,7 @@ Jdb_thread_list::sc_wfq_iter_next(Sched_context *t)
 
 
 // --------------------------------------------------------------------------
-IMPLEMENTATION [sched_fixed_prio || sched_fp_wfq]:
+IMPLEMENTATION [sched_fixed_prio || sched_fp_wfq || sched_fp_edf]:
 
 template<typename T> struct Jdb_thread_list_policy;
 
@@ -371,6 +371,55 @@ Jdb_thread_list::sc_iter_next(Sched_context *)
 }
 
 
+// --------------------------------------------------------------------------
+IMPLEMENTATION [sched_fp_edf]:
+
+template<>
+struct Jdb_thread_list_policy<Ready_queue_fp<Sched_context> >
+{
+  typedef Ready_queue_fp<Sched_context> Rq;
+
+  static unsigned prio(Sched_context *t)
+  { return t->prio(); }
+
+  static Sched_context *prio_next(Sched_context::Ready_queue &rq, unsigned prio)
+  { return rq.fp_rq.prio_next[prio].front(); }
+
+  static unsigned prio_highest(Sched_context::Ready_queue &rq)
+  { return rq.fp_rq.prio_highest; }
+
+  static Sched_context *prev(Sched_context *t)
+  { return *--Rq::List::iter(t); }
+
+  static Sched_context *next(Sched_context *t)
+  { return *++Rq::List::iter(t); }
+};
+
+// servers are not in the priority lists, walking starts over at the
+// highest priority from them
+static inline NOEXPORT
+Sched_context *
+Jdb_thread_list::sc_iter_prev(Sched_context *t)
+{
+  typedef Jdb_thread_list_policy<Ready_queue_fp<Sched_context> > Rqp;
+  if (t->type() == Sched_context::Edf)
+    return Rqp::prio_next(Sched_context::rq.cpu(cpu),
+                          Rqp::prio_highest(Sched_context::rq.cpu(cpu)));
+  return sc_fp_iter_prev<Rqp>(t);
+}
+
+static inline NOEXPORT
+Sched_context *
+Jdb_thread_list::sc_iter_next(Sched_context *t)
+{
+  typedef Jdb_thread_list_policy<Ready_queue_fp<Sched_context> > Rqp;
+  if (t->type() == Sched_context::Edf)
+    return Rqp::prio_next(Sched_context::rq.cpu(cpu),
+                          Rqp::prio_highest(Sched_context::rq.cpu(cpu)));
+  return sc_fp_iter_next<Rqp>(t);
+}
+
+
 // --------------------------------------------------------------------------
 IMPLEMENTATION:
 
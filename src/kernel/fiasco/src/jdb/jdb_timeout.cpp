@@ -4,6 +4,7 @@ IMPLEMENTATION:
 #include <cstring>
 
 #include "config.h"
+#include "cpu.h"
 #include "globals.h"
 #include "ipc_timeout.h"
 #include "jdb.h"
@@ -421,6 +422,50 @@ Jdb_list_timeouts::list()
     }
 }
 
+/**
+ * Show the occupancy of the timing wheels of all online CPUs. Each slot
+ * is one character: '.' for empty, the number of timeouts up to 9, '+'
+ * for more. The slot the wheel time points to is highlighted.
+ */
+static
+void
+Jdb_list_timeouts::show_wheel()
+{
+  unsigned const slots = Timeout_q::slots_per_level();
+
+  putchar('\n');
+  for (Cpu_number cpu = Cpu_number::first(); cpu < Config::max_num_cpus(); ++cpu)
+    {
+      if (!Cpu::online(cpu))
+        continue;
+
+      Timeout_q const &q = Timeout_q::timeout_queue.cpu(cpu);
+      printf("CPU%u:\n", cxx::int_value<Cpu_number>(cpu));
+
+      for (unsigned l = 0; l < Timeout_q::levels(); ++l)
+        {
+          String_buf<12> w;
+          Jdb::write_ll_ns(&w, Timeout_q::slot_width(l) * 1000, false);
+          w.terminate();
+
+          unsigned total = 0;
+          printf("  L%u %s ", l, w.begin());
+          for (unsigned i = 0; i < slots; ++i)
+            {
+              unsigned n = q.slot_length(l, i);
+              total += n;
+              char c = n == 0 ? '.' : n > 9 ? '+' : '0' + n;
+              if (i == q.current_slot(l))
+                printf("%s%c\033[m", Jdb::esc_emph, c);
+              else
+                putchar(c);
+            }
+          printf(" %4u\n", total);
+        }
+    }
+  putchar('\n');
+}
+
 PUBLIC
 Jdb_module::Action_code
 Jdb_list_timeouts::action(int cmd, void *&, char const *&, int &)
@@ -429,6 +474,8 @@ Jdb_list_timeouts::action(int cmd, void *&, char const *&, int &)
     list();
   else if (cmd == 1)
     complete_show();
+  else if (cmd == 2)
+    show_wheel();
 
   return NOTHING;
 }
@@ -441,6 +488,7 @@ Jdb_list_timeouts::cmds() const
     {
         { 0, "lt", "timeouts", "", "lt\tshow enqueued timeouts", 0 },
         { 1, "", "timeoutsdump", "", 0, 0 },
+        { 2, "lw", "timeoutwheel", "", "lw\tshow timeout wheel occupancy", 0 },
     };
 
   return cs;
@@ -450,7 +498,7 @@ PUBLIC
 int
 Jdb_list_timeouts::num_cmds() const
 {
-  return 2;
+  return 3;
 }
 
 static Jdb_list_timeouts jdb_list_timeouts INIT_PRIORITY(JDB_MODULE_INIT_PRIO);
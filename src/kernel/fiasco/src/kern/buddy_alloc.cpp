@@ -250,6 +250,22 @@ Buddy_t_base<A,B,M>::dump() const
   printf("sum of available memory: %ldK (%ld)\n", total / 1024, total);
 }
 
+/**
+ * Number of free blocks of size Min_size << size_index, for
+ * fragmentation statistics.
+ */
+PUBLIC
+template< int A, int B, int M >
+unsigned long
+Buddy_t_base<A,B,M>::free_blocks(unsigned size_index) const
+{
+  unsigned long n = 0;
+  for (B_list::Const_iterator h = _free[size_index].begin();
+       h != _free[size_index].end(); ++h)
+    ++n;
+  return n;
+}
+
 PUBLIC
 void
 Buddy_base::init(unsigned long base)
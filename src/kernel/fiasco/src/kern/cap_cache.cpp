@@ -0,0 +1,111 @@
+INTERFACE:
+
+#include "l4_types.h"
+#include "types.h"
+
+class Kobject_iface;
+class Space;
+
+/**
+ * Per-thread direct-mapped cache of capability translations.
+ *
+ * Server threads invoke a small set of capabilities over and over. The
+ * cache keeps the last translations of such capability indexes together
+ * with their rights. Every unmap or rights change in any object space
+ * bumps a global generation, which flushes all caches on their next use.
+ * Only valid capabilities are cached.
+ */
+class Cap_cache
+{
+public:
+  enum { Size = 8 };
+
+private:
+  struct Entry
+  {
+    Cap_index idx;
+    Kobject_iface *obj;
+    L4_fpage::Rights rights;
+  };
+
+  Entry _e[Size];
+  Space *_space;
+  Mword _gen;
+
+  static Mword _global_gen;
+};
+
+//---------------------------------------------------------------------------
+IMPLEMENTATION:
+
+#include "atomic.h"
+#include "mem.h"
+#include "space.h"
+
+Mword Cap_cache::_global_gen;
+
+PUBLIC inline
+Cap_cache::Cap_cache() : _space(0)
+{}
+
+/**
+ * Invalidate the caches of all threads.
+ *
+ * Must be called after a capability has been removed or its rights have
+ * been changed, before the object can be released.
+ */
+PUBLIC static inline NEEDS["atomic.h", "mem.h"]
+void
+Cap_cache::invalidate_all()
+{
+  Mem::mp_wmb();
+  atomic_add(&_global_gen, 1);
+}
+
+PRIVATE inline NOEXPORT
+void
+Cap_cache::flush(Space *s, Mword gen)
+{
+  for (unsigned i = 0; i < Size; ++i)
+    _e[i].obj = 0;
+
+  _space = s;
+  _gen = gen;
+}
+
+/**
+ * Translate capability index idx in object space s.
+ * \pre cpu lock held
+ */
+PUBLIC
+Kobject_iface *
+Cap_cache::lookup(Space *s, Cap_index idx, L4_fpage::Rights *rights)
+{
+  Mword gen = access_once(&_global_gen);
+  if (EXPECT_FALSE(_space != s || _gen != gen))
+    flush(s, gen);
+
+  Entry *e = &_e[cxx::int_value<Cap_index>(idx) & (Size - 1)];
+  if (EXPECT_TRUE(e->obj && e->idx == idx))
+    {
+      if (rights)
+        *rights = e->rights;
+      return e->obj;
+    }
+
+  // the generation must be read before the capability
+  Mem::mp_rmb();
+
+  L4_fpage::Rights r;
+  Kobject_iface *o = s->lookup_local(idx, &r);
+  if (o)
+    {
+      e->idx = idx;
+      e->obj = o;
+      e->rights = r;
+    }
+
+  if (rights)
+    *rights = r;
+  return o;
+}
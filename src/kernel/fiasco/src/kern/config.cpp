@@ -66,6 +66,9 @@ public:
     One_shot_min_interval_us =   200,
     One_shot_max_interval_us = 10000,
 
+    // upper bound for the cache-line size, used to keep per-CPU data apart
+    Cache_line_size = 64,
+
 
 #ifdef CONFIG_FINE_GRAINED_CPUTIME
     Fine_grained_cputime = true,
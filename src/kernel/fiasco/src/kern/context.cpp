@@ -536,6 +536,7 @@ IMPLEMENTATION:
 #include "fpu.h"
 #include "globals.h"		// current()
 #include "kdb_ke.h"
+#include "lat_hist.h"
 #include "lock_guard.h"
 #include "logdefs.h"
 #include "mem.h"
@@ -1306,7 +1307,9 @@ Context::switch_exec_locked(Context *t, enum Helping_mode mode)
 
   t->set_current_cpu(get_current_cpu());
   switch_fpu(t);
+  Lat_hist::switch_begin();
   switch_cpu(t);
+  Lat_hist::switch_end();
 
   return switch_handle_drq();
 }
@@ -1355,7 +1358,9 @@ Context::switch_exec_helping(Context *t, Helping_mode mode, Mword const *lock, M
   t->set_helper(mode);
   t->set_current_cpu(get_current_cpu());
   switch_fpu(t);
+  Lat_hist::switch_begin();
   switch_cpu(t);
+  Lat_hist::switch_end();
   return switch_handle_drq();
 }
 
@@ -2013,8 +2018,33 @@ protected:
   class Pending_rq : public Queue_item, public Context_member
   {} _pending_rq;
 
+  /**
+   * \brief Lock-free inbound queue of contexts with pending DRQs.
+   *
+   * Remote CPUs push a context with a single CAS and without touching
+   * the pending-request queue lock of the target CPU. Only the push that
+   * makes the inbox non-empty raises an IPI, the receiving CPU then takes
+   * the whole batch at once.
+   */
+  class Drq_inbox
+  {
+  public:
+    Drq_inbox() : _head(0) {}
+    bool push(Context *c);
+    Context *take_all();
+    bool empty() const { return !access_once(&_head); }
+
+  private:
+    Context *_head;
+  };
+
+  /// link in the Drq_inbox, only valid while _in_drq_inbox is set
+  Context *_drq_inbox_next;
+  Mword _in_drq_inbox;
+
 protected:
   static Per_cpu<Pending_rqq> _pending_rqq;
+  static Per_cpu<Drq_inbox> _drq_inbox;
   static Per_cpu<Cpu_call_queue> _glbl_q;
   static Cpu_mask _tlb_active;
 
@@ -2032,6 +2062,7 @@ IMPLEMENTATION [mp]:
 #include "mem.h"
 
 DEFINE_PER_CPU Per_cpu<Context::Pending_rqq> Context::_pending_rqq;
+DEFINE_PER_CPU Per_cpu<Context::Drq_inbox> Context::_drq_inbox;
 DEFINE_PER_CPU Per_cpu<Context::Cpu_call_queue> Context::_glbl_q;
 Cpu_mask Context::_tlb_active;
 
@@ -2145,6 +2176,126 @@ Context::Pending_rqq::enq(Context *c)
 }
 
 
+/**
+ * \brief Push \a c into the inbox.
+ * \return true if the inbox was empty before, in this case the caller
+ *         must notify the owning CPU.
+ */
+IMPLEMENT inline NEEDS["atomic.h"]
+bool
+Context::Drq_inbox::push(Context *c)
+{
+  Context *h;
+  do
+    {
+      h = access_once(&_head);
+      c->_drq_inbox_next = h;
+    }
+  while (!mp_cas(&_head, h, c));
+
+  return !h;
+}
+
+/**
+ * \brief Take the whole batch out of the inbox.
+ * \pre The pending-request queue lock of the owning CPU is held.
+ * \return The contexts in arrival order, linked via _drq_inbox_next.
+ */
+IMPLEMENT inline NEEDS["atomic.h"]
+Context *
+Context::Drq_inbox::take_all()
+{
+  Context *h;
+  do
+    h = access_once(&_head);
+  while (h && !mp_cas(&_head, h, (Context *)0));
+
+  // the inbox is a LIFO, restore the order of arrival
+  Context *r = 0;
+  while (h)
+    {
+      Context *n = h->_drq_inbox_next;
+      h->_drq_inbox_next = r;
+      r = h;
+      h = n;
+    }
+  return r;
+}
+
+/**
+ * \brief Move all contexts from the DRQ inbox of \a cpu into the
+ *        pending-request queue of \a cpu.
+ * \pre The queue lock of _pending_rqq.cpu(cpu) is held.
+ * \return Contexts that migrated away meanwhile, they must be handed to
+ *         forward_drq_inbox() after releasing the queue lock.
+ */
+PRIVATE static
+Context *
+Context::drain_drq_inbox(Cpu_number cpu)
+{
+  Queue &q = _pending_rqq.cpu(cpu);
+  assert_kdb (q.q_lock()->test());
+
+  Context *c = _drq_inbox.cpu(cpu).take_all();
+  Context *fwd = 0;
+  Mword n = 0;
+
+  while (c)
+    {
+      Context *next = c->_drq_inbox_next;
+      ++n;
+
+      // the queue lock of 'cpu' keeps contexts from migrating away from it
+      if (EXPECT_FALSE(access_once(&c->_home_cpu) != cpu))
+        {
+          c->_drq_inbox_next = fwd;
+          fwd = c;
+        }
+      else
+        {
+          if (!c->_pending_rq.queued())
+            q.enqueue(&c->_pending_rq);
+
+          Mem::mp_mb();
+          write_now(&c->_in_drq_inbox, Mword(false));
+        }
+
+      c = next;
+    }
+
+  if (n)
+    CNT_DRQ_BATCH(n);
+
+  return fwd;
+}
+
+/**
+ * \brief Hand contexts that migrated while sitting in a DRQ inbox over to
+ *        their new home CPU.
+ *
+ * Nobody would pick up the requests of a context whose new home CPU is
+ * offline, so we execute them here on behalf of that CPU.
+ */
+PRIVATE static
+void
+Context::forward_drq_inbox(Context *c)
+{
+  while (c)
+    {
+      Context *next = c->_drq_inbox_next;
+      Mem::mp_mb();
+      write_now(&c->_in_drq_inbox, Mword(false));
+
+      Cpu_number cpu = access_once(&c->_home_cpu);
+      if (EXPECT_FALSE(!Cpu::online(cpu)))
+        c->enqueue_drq_offline(0, cpu);
+      else
+        c->pending_rqq_enqueue();
+
+      c = next;
+    }
+}
+
 /**
  * \brief Wakeup all contexts with pending DRQs.
  *
@@ -2159,6 +2310,14 @@ Context::Pending_rqq::handle_requests(Context **mq)
     printf("CPU[%2u:%p]: Context::Pending_rqq::handle_requests() this=%p\n", cxx::int_value<Cpu_number>(current_cpu()), current(), this);
   bool resched = false;
   Context *curr = current();
+
+  Context *fwd;
+    {
+      auto guard = lock_guard(q_lock());
+      fwd = drain_drq_inbox(current_cpu());
+    }
+  forward_drq_inbox(fwd);
+
   while (1)
     {
       Context *c;
@@ -2306,13 +2465,21 @@ Context::take_cpu_offline(Cpu_number cpu)
       Queue &q = Context::_pending_rqq.current();
       auto guard = lock_guard(q.q_lock());
 
-      if (q.first())
+      if (q.first() || !_drq_inbox.current().empty())
         return;
 
       Cpu::cpus.current().set_online(false);
     }
   Mem::mp_mb();
 
+  // A DRQ sender that saw us online may have pushed into the inbox
+  // meanwhile, stay online so that its IPI is not lost.
+  if (EXPECT_FALSE(!_drq_inbox.current().empty()))
+    {
+      Cpu::cpus.current().set_online(true);
+      Mem::mp_mb();
+    }
+
   handle_global_requests();
 }
 
@@ -2424,33 +2591,85 @@ Context::enqueue_drq(Drq *rq, Drq::Exec_mode /*exec*/)
   if (EXPECT_FALSE(cpu == current_cpu))
     return _deq_exec_drq(rq);
 
-  bool ipi = false;
+  if (EXPECT_FALSE(!Cpu::online(cpu)))
+    return enqueue_drq_offline(rq, cpu);
 
+  // Somebody else already announced us to our CPU and the inbox is not yet
+  // drained, our request will be handled with that batch.
+  if (!mp_cas(&_in_drq_inbox, Mword(false), Mword(true)))
+    {
+      CNT_DRQ_IPI_SAVED;
+      return false;
+    }
+
+  bool ipi = _drq_inbox.cpu(cpu).push(this);
+
+  // pairs with the barrier in take_cpu_offline()
+  Mem::mp_mb();
+  if (EXPECT_FALSE(!Cpu::online(cpu)))
+    return enqueue_drq_offline(rq, cpu);
+
+  if (ipi)
+    Ipi::send(Ipi::Request, current_cpu, cpu);
+  else
+    CNT_DRQ_IPI_SAVED;
+
+  return false;
+}
+
+/**
+ * \brief Slow path of enqueue_drq() for a home CPU that is offline.
+ *
+ * The CPU cannot drain its DRQ inbox, so we do it under its queue lock
+ * and execute our requests on behalf of the offline CPU.
+ *
+ * \param rq  The request just enqueued, 0 to execute only the requests
+ *            already in our queue.
+ */
+PRIVATE
+bool
+Context::enqueue_drq_offline(Drq *rq, Cpu_number cpu)
+{
+  bool ipi = false;
+  bool run = true;
+  Context *fwd;
     {
       Queue &q = Context::_pending_rqq.cpu(cpu);
       auto guard = lock_guard(q.q_lock());
 
+      fwd = drain_drq_inbox(cpu);
+
       // migrated between getting the lock and reading the CPU, so the
       // new CPU is responsible for executing our request
       if (access_once(&_home_cpu) != cpu)
-        return false;
-
-      if (EXPECT_FALSE(!Cpu::online(cpu)))
-        return _deq_exec_drq(rq, true);
-
-      if (!_pending_rq.queued())
+        run = false;
+      else if (EXPECT_FALSE(Cpu::online(cpu)))
         {
-          if (!q.first())
-            ipi = true;
-
-          q.enqueue(&_pending_rq);
+          // back online already, just notify it
+          if (!_pending_rq.queued())
+            q.enqueue(&_pending_rq);
+          ipi = true;
+          run = false;
         }
+      else if (_pending_rq.queued())
+        check_kdb (q.dequeue(&_pending_rq, Queue_item::Ok));
     }
 
+  forward_drq_inbox(fwd);
+
   if (ipi)
-    Ipi::send(Ipi::Request, current_cpu, cpu);
+    Ipi::send(Ipi::Request, ::current_cpu(), cpu);
 
-  return false;
+  if (!run)
+    return false;
+
+  // requests of concurrent senders that found us in the inbox are in our
+  // queue too, nobody else is going to execute them
+  bool resched = rq && _deq_exec_drq(rq, true);
+  while (Drq *r = static_cast<Drq *>(_drq_q.first()))
+    resched |= _deq_exec_drq(r, true);
+
+  return resched;
 }
 
 
@@ -2526,6 +2745,8 @@ Context::switch_fpu(Context *t)
     f.disable();
   else if (f.is_owner(t) && !(t->state() & Thread_vcpu_fpu_disabled))
     f.enable();
+
+  switch_fpu_eager(t);
 }
 
 //----------------------------------------------------------------------------
@@ -2552,8 +2773,111 @@ Context::switch_fpu(Context *t)
     f.enable();
   else
     assert_kdb(!Fpu::is_enabled());
+
+  switch_fpu_eager(t);
+}
+
+//----------------------------------------------------------------------------
+INTERFACE [fpu_eager]:
+
+EXTENSION class Context
+{
+private:
+  /// FPU usage of a context in its current timeslice
+  enum Fpu_slice
+  {
+    Fpu_slice_lazy = 0, ///< No FPU trap so far
+    Fpu_slice_used,     ///< Took an FPU trap
+    Fpu_slice_keep,     ///< FPU enabled on switch-in, usage unknown
+  };
+
+  enum
+  {
+    Fpu_eager_history = CONFIG_FPU_EAGER_HISTORY,
+    /// Every Fpu_eager_probe-th switch-in stays lazy to detect FPU disuse
+    Fpu_eager_probe = 16,
+  };
+
+  /// Number of consecutive timeslices with FPU use
+  Unsigned8 _fpu_hist;
+  Unsigned8 _fpu_slice;
+  Unsigned8 _fpu_probe;
+};
+
+//----------------------------------------------------------------------------
+IMPLEMENTATION [fpu && !ux && fpu_eager]:
+
+#include "logdefs.h"
+
+/**
+ * Record an FPU trap of this context in its current timeslice.
+ */
+PROTECTED inline
+void
+Context::fpu_mark_used()
+{ _fpu_slice = Fpu_slice_used; }
+
+/**
+ * Update the FPU-usage history of this context when switching away from
+ * it, and restore the FPU state of t right away if t used the FPU in its
+ * last Fpu_eager_history timeslices. This saves t the FPU trap.
+ */
+PRIVATE inline NEEDS ["fpu.h", "logdefs.h"]
+void
+Context::switch_fpu_eager(Context *t)
+{
+  if (_fpu_slice == Fpu_slice_used)
+    {
+      if (_fpu_hist < 255)
+        ++_fpu_hist;
+    }
+  else if (_fpu_slice == Fpu_slice_lazy && _fpu_hist)
+    {
+      if (_fpu_hist >= Fpu_eager_history)
+        CNT_FPU_EAGER_DROP;
+      _fpu_hist = 0;
+    }
+
+  _fpu_slice = Fpu_slice_lazy;
+
+  Fpu &f = Fpu::fpu.current();
+  if (f.is_owner(t))
+    {
+      // does not trap, keep the history until t loses the FPU
+      t->_fpu_slice = Fpu_slice_keep;
+      return;
+    }
+
+  if (t->_fpu_hist < Fpu_eager_history
+      || !t->fpu_state()->state_buffer()
+      || (t->state() & Thread_vcpu_fpu_disabled)
+      || !(++t->_fpu_probe % Fpu_eager_probe))
+    return;
+
+  f.enable();
+  if (f.owner())
+    f.owner()->spill_fpu();
+
+  f.restore_state(t->fpu_state());
+  t->state_add_dirty(Thread_fpu_owner);
+  f.set_owner(t);
+  t->_fpu_slice = Fpu_slice_keep;
+  CNT_FPU_EAGER;
 }
 
+//----------------------------------------------------------------------------
+IMPLEMENTATION [!fpu_eager]:
+
+PROTECTED inline
+void
+Context::fpu_mark_used()
+{}
+
+PRIVATE inline
+void
+Context::switch_fpu_eager(Context *)
+{}
+
 //----------------------------------------------------------------------------
 IMPLEMENTATION [!fpu]:
 
@@ -6,6 +6,8 @@ INTERFACE:
 #include "member_offs.h"
 #include "sender.h"
 #include "context.h"
+#include "spin_lock.h"
+#include "timeout.h"
 
 class Ram_quota;
 class Thread;
@@ -31,6 +33,7 @@ public:
     Op_trigger    = 2,
     Op_chain      = 3,
     Op_eoi_2      = 4,
+    Op_coalesce   = 5,
   };
 
 private:
@@ -52,15 +55,50 @@ class Irq_sender
 public:
   Mword kobject_size() const { return sizeof(*this); }
 
+  enum
+  {
+    Coalesce_poll = 1, ///< Op_coalesce flag: polling mode
+    Eoi_busy      = 1, ///< EOI flag: handler still busy (polling mode)
+    Coalesce_max_delay = 1000000, ///< max. delay in microseconds
+  };
+
 private:
   Irq_sender(Irq_sender &);
 
+  /// Delivers coalesced events or poll ticks after the configured delay.
+  class Coalesce_timeout : public Timeout
+  {
+  public:
+    Irq_sender *irq;
+
+  private:
+    bool expired();
+  };
+
 protected:
   Smword _queued;
   Thread *_irq_thread;
 
 private:
   Mword _irq_id;
+
+  // Interrupt coalescing and polling. With _coalesce_max > 1, edge
+  // triggered hits only count in _events until _coalesce_max is reached
+  // or _coalesce_delay has passed, and the message carries the count.
+  // In polling mode the line stays masked while the handler answers
+  // with a busy EOI, it then gets a poll tick after _coalesce_delay.
+  Mword _coalesce_max;
+  Unsigned32 _coalesce_delay;
+  bool _polling;
+  bool _poll_busy;
+  Mword _events;
+  // The timeout is only ever queued on _coalesce_cpu, other CPUs arm it
+  // with _coalesce_drq. _coalesce_cpu is fixed while coalescing is on.
+  Cpu_number _coalesce_cpu;
+  bool _arm_queued;
+  Spin_lock<> _coalesce_lock;
+  Coalesce_timeout _coalesce_to;
+  Context::Drq _coalesce_drq;
 };
 
 
@@ -111,6 +149,7 @@ IMPLEMENTATION:
 #include "std_macros.h"
 #include "thread_object.h"
 #include "thread_state.h"
+#include "timer.h"
 #include "l4_buf_iter.h"
 #include "vkey.h"
 
@@ -366,9 +405,13 @@ Irq_sender::free(Thread *t, Kobject ***rl)
 
 PUBLIC explicit
 Irq_sender::Irq_sender(Ram_quota *q = 0)
-: Kobject_h<Irq_sender, Irq>(q), _queued(0), _irq_thread(0), _irq_id(~0UL)
+: Kobject_h<Irq_sender, Irq>(q), _queued(0), _irq_thread(0), _irq_id(~0UL),
+  _coalesce_max(0), _coalesce_delay(0), _polling(false), _poll_busy(false),
+  _events(0), _coalesce_cpu(Cpu_number::nil()), _arm_queued(false)
 {
   hit_func = &hit_level_irq;
+  _coalesce_lock.init();
+  _coalesce_to.irq = this;
 }
 
 PUBLIC
@@ -382,6 +425,8 @@ PUBLIC
 void
 Irq_sender::destroy(Kobject ***rl)
 {
+  stop_coalescing();
+
   auto g = lock_guard(cpu_lock);
   auto t = access_once(&_irq_thread);
   if (t)
@@ -406,7 +451,7 @@ Irq_sender::consume()
     }
   while (!mp_cas (&_queued, old, old - 1));
 
-  if (old == 2 && hit_func == &hit_edge_irq)
+  if (old == 2 && hit_func == &hit_edge_irq && !_polling)
     unmask();
 
   return old - 1;
@@ -465,6 +510,18 @@ Irq_sender::transfer_msg(Receiver *recv)
     // set ipc return value: OK
     dst_regs->tag(L4_msg_tag(0));
 
+  // report the number of coalesced events
+  if (EXPECT_FALSE(_coalesce_max > 1 || _polling))
+    {
+      Mword n;
+      do
+        n = _events;
+      while (!mp_cas(&_events, n, Mword(0)));
+
+      recv->utcb().access()->values[0] = n;
+      dst_regs->tag(L4_msg_tag(1, 0, 0, dst_regs->tag().proto()));
+    }
+
   // set ipc source thread id
   dst_regs->from(_irq_id);
 
@@ -513,9 +570,13 @@ Irq_sender::queue()
 }
 
 
+/**
+ * \return true if a reschedule is necessary, only meaningful if
+ *         might_switch is false.
+ */
 PRIVATE inline
-void
-Irq_sender::count_and_send(Smword queued)
+bool
+Irq_sender::count_and_send(Smword queued, bool might_switch = true)
 {
   if (EXPECT_TRUE (queued == 0) && EXPECT_TRUE(_irq_thread != 0))	// increase hit counter
     {
@@ -523,8 +584,193 @@ Irq_sender::count_and_send(Smword queued)
 	_irq_thread->drq(&_drq, handle_remote_hit, this,
 	                 Context::Drq::Target_ctxt, Context::Drq::No_wait);
       else
-	send_msg(_irq_thread, true);
+	return send_msg(_irq_thread, might_switch);
+    }
+  return false;
+}
+
+PRIVATE static
+Context::Drq::Result
+Irq_sender::handle_remote_arm(Context::Drq *, Context *, void *arg)
+{
+  Irq_sender *irq = (Irq_sender*)arg;
+  {
+    auto guard = lock_guard(irq->_coalesce_lock);
+    irq->_arm_queued = false;
+  }
+
+  irq->arm_coalesce_timeout();
+  return Context::Drq::no_answer();
+}
+
+/**
+ * Arm the coalescing timeout, if it is not armed yet. The timeout is
+ * queued on _coalesce_cpu only, as Timeout_q::do_timeouts() works on it
+ * without the coalescing lock. Other CPUs leave arming to a DRQ there.
+ * \pre cpu lock held
+ */
+PRIVATE
+void
+Irq_sender::arm_coalesce_timeout()
+{
+  auto guard = lock_guard(_coalesce_lock);
+  if (!_coalesce_delay || _coalesce_to.is_set())
+    return;
+
+  Cpu_number cpu = _coalesce_cpu;
+  if (cpu == current_cpu())
+    {
+      _coalesce_to.set(Timer::system_clock() + _coalesce_delay, cpu);
+      return;
+    }
+
+  if (_arm_queued)
+    return;
+
+  _arm_queued = true;
+  Context::kernel_context(cpu)->drq(&_coalesce_drq, handle_remote_arm, this,
+                                    Context::Drq::Any_ctxt,
+                                    Context::Drq::No_wait);
+}
+
+/**
+ * Send a message for the events counted so far, unless a message is
+ * already pending, which then takes them along.
+ * \pre cpu lock held
+ */
+PRIVATE
+bool
+Irq_sender::flush_events(bool might_switch)
+{
+  if (mp_cas(&_queued, Smword(0), Smword(1)))
+    return count_and_send(0, might_switch);
+
+  // events counted after the pending message was transferred would
+  // otherwise wait for the next hit
+  arm_coalesce_timeout();
+  return false;
+}
+
+/**
+ * Count one edge triggered hit in coalescing mode.
+ * \pre cpu lock held
+ */
+PRIVATE inline NEEDS[Irq_sender::flush_events, Irq_sender::arm_coalesce_timeout]
+void
+Irq_sender::coalesce_hit()
+{
+  Mword n;
+  do
+    n = _events;
+  while (!mp_cas(&_events, n, n + 1));
+
+  if (n + 1 >= _coalesce_max)
+    flush_events(true);
+  else
+    arm_coalesce_timeout();
+}
+
+PRIVATE
+bool
+Irq_sender::coalesce_expired()
+{
+  {
+    auto guard = lock_guard(_coalesce_lock);
+    // armed again in the meantime
+    if (_coalesce_to.is_set())
+      return false;
+  }
+
+  if (_poll_busy)
+    {
+      // poll tick for a busy handler, the line is still masked
+      _poll_busy = false;
+      return flush_events(false);
     }
+
+  if (access_once(&_events))
+    return flush_events(false);
+
+  return false;
+}
+
+IMPLEMENT
+bool
+Irq_sender::Coalesce_timeout::expired()
+{ return irq->coalesce_expired(); }
+
+PRIVATE static
+Context::Drq::Result
+Irq_sender::handle_remote_stop(Context::Drq *, Context *, void *arg)
+{
+  Irq_sender *irq = (Irq_sender*)arg;
+  auto guard = lock_guard(irq->_coalesce_lock);
+  if (irq->_coalesce_to.is_set())
+    irq->_coalesce_to.reset();
+  return Context::Drq::done();
+}
+
+/**
+ * Switch off coalescing and polling and make sure the coalescing timeout
+ * is not queued anymore. The stop request runs after a pending arming
+ * DRQ on the same CPU, which then finds coalescing off.
+ */
+PRIVATE
+void
+Irq_sender::stop_coalescing()
+{
+  auto guard = lock_guard(cpu_lock);
+  Cpu_number cpu;
+    {
+      auto g = lock_guard(_coalesce_lock);
+      _coalesce_max = 0;
+      _coalesce_delay = 0;
+      _polling = false;
+      _poll_busy = false;
+      cpu = _coalesce_cpu;
+    }
+
+  if (cpu == Cpu_number::nil())
+    return;
+
+  if (cpu == current_cpu())
+    handle_remote_stop(0, 0, this);
+  else
+    Context::kernel_context(cpu)->drq(handle_remote_stop, this,
+                                      Context::Drq::Any_ctxt);
+
+  // the timeout is gone, coalescing may move to another CPU now unless
+  // it got switched on again in the meantime
+  auto g = lock_guard(_coalesce_lock);
+  if (!_coalesce_delay)
+    _coalesce_cpu = Cpu_number::nil();
+}
+
+PRIVATE
+L4_msg_tag
+Irq_sender::sys_coalesce(L4_msg_tag const &tag, Utcb const *utcb)
+{
+  if (EXPECT_FALSE(tag.words() < 4))
+    return commit_result(-L4_err::EInval);
+
+  Mword max = utcb->values[1];
+  Mword delay = utcb->values[2];
+  bool poll = utcb->values[3] & Coalesce_poll;
+
+  // a partially filled batch needs a deadline
+  if (delay > Coalesce_max_delay || ((max > 1 || poll) && !delay))
+    return commit_result(-L4_err::EInval);
+
+  auto guard = lock_guard(_coalesce_lock);
+  if (_coalesce_cpu == Cpu_number::nil())
+    _coalesce_cpu = current_cpu();
+  _coalesce_max = max;
+  _coalesce_delay = delay;
+  _polling = poll;
+  if (!poll)
+    _poll_busy = false;
+
+  return commit_result(0);
 }
 
 
@@ -544,6 +790,8 @@ Irq_sender::_hit_level_irq(Upstream_irq const *ui)
   assert (cpu_lock.test());
   mask_and_ack();
   ui->ack();
+  if (EXPECT_FALSE(_coalesce_max > 1 || _polling))
+    atomic_add(&_events, 1);
   count_and_send(queue());
 }
 
@@ -552,7 +800,8 @@ void
 Irq_sender::hit_level_irq(Irq_base *i, Upstream_irq const *ui)
 { nonull_static_cast<Irq_sender*>(i)->_hit_level_irq(ui); }
 
-PUBLIC inline NEEDS[Irq_sender::count_and_send, Irq_sender::queue]
+PUBLIC inline NEEDS[Irq_sender::count_and_send, Irq_sender::queue,
+                    Irq_sender::coalesce_hit, "atomic.h"]
 void
 Irq_sender::_hit_edge_irq(Upstream_irq const *ui)
 {
@@ -566,6 +815,24 @@ Irq_sender::_hit_edge_irq(Upstream_irq const *ui)
   // LOG_MSG_3VAL(current(), "IRQ", dbg_id(), 0, _queued);
 
   assert (cpu_lock.test());
+  if (EXPECT_FALSE(_polling))
+    {
+      // keep the line masked until the handler is not busy anymore
+      mask_and_ack();
+      ui->ack();
+      atomic_add(&_events, 1);
+      count_and_send(queue());
+      return;
+    }
+
+  if (EXPECT_FALSE(_coalesce_max > 1))
+    {
+      ack();
+      ui->ack();
+      coalesce_hit();
+      return;
+    }
+
   Smword q = queue();
 
   // if we get a second edge triggered IRQ before the first is
@@ -651,6 +918,15 @@ Irq_sender::kinvoke(L4_obj_ref, L4_fpage::Rights /*rights*/, Syscall_frame *f,
     {
     case Op_eoi_1:
     case Op_eoi_2:
+      if (EXPECT_FALSE(_polling) && tag.words() >= 2
+          && (utcb->values[1] & Eoi_busy))
+        {
+          // the handler still has work, poll it again instead of unmasking
+          _poll_busy = true;
+          arm_coalesce_timeout();
+          return no_reply();
+        }
+
       if (_queued < 1)
 	unmask();
 
@@ -661,6 +937,8 @@ Irq_sender::kinvoke(L4_obj_ref, L4_fpage::Rights /*rights*/, Syscall_frame *f,
       log();
       hit(0);
       return no_reply();
+    case Op_coalesce:
+      return sys_coalesce(tag, utcb);
     default:
       return commit_result(-L4_err::EInval);
     }
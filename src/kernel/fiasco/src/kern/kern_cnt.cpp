@@ -54,6 +54,12 @@ Kern_cnt::get_str(Mword num)
     case Kern_cnt_schedule:          return "Scheduler calls";
     case Kern_cnt_iobmap_tlb_flush:  return "IO bitmap TLB flushs";
     case Kern_cnt_exc_ipc:           return "Exception IPCs";
+    case Kern_cnt_drq_ipi_saved:     return "DRQ IPIs saved";
+    case Kern_cnt_drq_batches:       return "DRQ batches";
+    case Kern_cnt_drq_batch_items:   return "DRQ batched requests";
+    case Kern_cnt_fpu_trap:          return "FPU traps";
+    case Kern_cnt_fpu_eager:         return "FPU eager switches";
+    case Kern_cnt_fpu_eager_drop:    return "FPU eager switches dropped";
     default:                         return 0;
     }
 }
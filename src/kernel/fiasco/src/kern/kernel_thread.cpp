@@ -123,7 +123,7 @@ Kernel_thread::run()
 }
 
 // ------------------------------------------------------------------------
-IMPLEMENTATION [!arch_idle && !tickless_idle]:
+IMPLEMENTATION [!arch_idle && !tickless_idle && !tickless]:
 
 PUBLIC inline NEEDS["processor.h"]
 void
@@ -137,7 +137,7 @@ Kernel_thread::idle_op()
 
 
 // ------------------------------------------------------------------------
-IMPLEMENTATION [tickless_idle]:
+IMPLEMENTATION [tickless_idle || tickless]:
 
 #include <rcupdate.h>
 
@@ -153,6 +153,9 @@ private:
 DEFINE_PER_CPU Per_cpu<unsigned long> Kernel_thread::_idle_counter;
 DEFINE_PER_CPU Per_cpu<unsigned long> Kernel_thread::_deep_idle_counter;
 
+// ------------------------------------------------------------------------
+IMPLEMENTATION [tickless_idle]:
+
 // template code for arch idle
 PUBLIC
 void
@@ -189,3 +192,42 @@ Kernel_thread::idle_op()
 }
 
 
+
+// ------------------------------------------------------------------------
+IMPLEMENTATION [tickless]:
+
+#include <climits>
+#include "timer.h"
+
+/**
+ * Idle with the scheduling tick stopped until the next pending timeout.
+ * The timeslice of the idle thread is no reason to wake up.
+ */
+PUBLIC
+void
+Kernel_thread::idle_op()
+{
+  // RCU must be active again before any interrupt handler runs, an
+  // arch_tickless_idle() taking interrupts in the wait has to see to it
+  auto guard = lock_guard(cpu_lock);
+  Cpu_number cpu = home_cpu();
+  ++_idle_counter.cpu(cpu);
+
+  if (Rcu::idle(cpu))
+    {
+      Unsigned64 wakeup = Timeout_q::timeout_queue.cpu(cpu)
+        .next_event(ULONG_LONG_MAX, timeslice_timeout.cpu(cpu));
+
+      if (Timer::stop_tick(cpu, wakeup, false))
+        {
+          ++_deep_idle_counter.cpu(cpu);
+          Rcu::enter_idle(cpu);
+          arch_tickless_idle(cpu);
+          Rcu::leave_idle(cpu);
+          Timer::restart_tick(cpu);
+          return;
+        }
+    }
+
+  arch_idle(cpu);
+}
@@ -3,9 +3,11 @@ INTERFACE:
 #include <auto_quota.h>
 #include <cxx/slist>
 
+#include "config.h"
 #include "spin_lock.h"
 #include "lock_guard.h"
 #include "initcalls.h"
+#include "per_cpu_data.h"
 
 class Buddy_alloc;
 class Mem_region_map_base;
@@ -19,12 +21,77 @@ class Kmem_alloc
 
 public:
   typedef Buddy_alloc Alloc;
+
+  //
+  // Per-CPU hot lists for one- and two-page blocks in front of the buddy
+  // allocator, so that page-table and UTCB allocations do not contend for
+  // the global lock. Each list is refilled and drained in batches.
+  //
+  enum
+  {
+    Hot_classes = 2,  ///< hot lists for PAGE_SIZE and 2 * PAGE_SIZE
+    Hot_batch   = 8,  ///< blocks moved between a hot list and the buddy
+    Hot_max     = 32, ///< max. blocks in one hot list
+    Large_pool_blocks = 2, ///< reserved blocks of the largest buddy size
+  };
+
+  struct Hot_stats
+  {
+    unsigned long hits;   ///< allocations served from the hot list
+    unsigned long misses; ///< allocations that went to the buddy
+    unsigned count;       ///< blocks in the hot list
+  };
+
 private:
   typedef Spin_lock<> Lock;
   static Lock lock;
   static Alloc *a;
   static unsigned long _orig_free;
   static Kmem_alloc *_alloc;
+
+  /// Free block linked into a hot list or the large pool.
+  struct Free_block
+  {
+    Free_block *next;
+  };
+
+  struct Hot_list
+  {
+    Free_block *head;
+    unsigned count;
+    unsigned long hits, misses;
+
+    void push(void *b)
+    {
+      Free_block *f = reinterpret_cast<Free_block *>(b);
+      f->next = head;
+      head = f;
+      ++count;
+    }
+
+    void *pop()
+    {
+      Free_block *f = head;
+      head = f->next;
+      --count;
+      return f;
+    }
+  };
+
+  struct Hot_cpu
+  {
+    Hot_list list[Hot_classes];
+    unsigned long trim_gen;
+  } __attribute__((aligned(Config::Cache_line_size)));
+
+  static Per_cpu_array<Hot_cpu> _hot;
+  static unsigned long _hot_trim_gen;
+
+  // Naturally aligned blocks of Alloc::Max_size set aside at boot. They
+  // back large allocations once fragmentation leaves none in the buddy.
+  static Free_block *_large_pool;
+  static unsigned _large_pool_blocks;
+  static unsigned long _large_pool_used;
 };
 
 
@@ -77,7 +144,10 @@ IMPLEMENTATION:
 
 #include <cassert>
 
+#include "atomic.h"
 #include "config.h"
+#include "context_base.h"
+#include "cpu_lock.h"
 #include "kdb_ke.h"
 #include "kip.h"
 #include "mem_layout.h"
@@ -90,6 +160,11 @@ Kmem_alloc::Alloc *Kmem_alloc::a = &_a;
 unsigned long Kmem_alloc::_orig_free;
 Kmem_alloc::Lock Kmem_alloc::lock;
 Kmem_alloc* Kmem_alloc::_alloc;
+Per_cpu_array<Kmem_alloc::Hot_cpu> Kmem_alloc::_hot;
+unsigned long Kmem_alloc::_hot_trim_gen;
+Kmem_alloc::Free_block *Kmem_alloc::_large_pool;
+unsigned Kmem_alloc::_large_pool_blocks;
+unsigned long Kmem_alloc::_large_pool_used;
 
 PUBLIC static inline NEEDS[<cassert>]
 Kmem_alloc *
@@ -121,6 +196,7 @@ Kmem_alloc::init()
 {
   static Kmem_alloc al;
   Kmem_alloc::allocator(&al);
+  fill_large_pool();
 }
 
 PUBLIC
@@ -143,6 +219,175 @@ Kmem_alloc::free(size_t o, void *p)
   unaligned_free(1UL << o, p);
 }
 
+/**
+ * The hot list index for blocks of the given size.
+ * \return the index, or -1 if blocks of this size are not cached
+ */
+PRIVATE static inline
+int
+Kmem_alloc::hot_class(unsigned long size)
+{
+  if (size == Config::PAGE_SIZE)
+    return 0;
+  if (size == 2 * Config::PAGE_SIZE)
+    return 1;
+  return -1;
+}
+
+/**
+ * Return all blocks of the hot lists of `c` to the buddy allocator.
+ * \pre CPU lock held
+ */
+PRIVATE static
+void
+Kmem_alloc::drain_hot(Hot_cpu *c)
+{
+  auto guard = lock_guard(lock);
+  for (unsigned i = 0; i < Hot_classes; ++i)
+    while (c->list[i].count)
+      a->free(c->list[i].pop(), Config::PAGE_SIZE << i);
+}
+
+/**
+ * The hot lists of the current CPU after a pending trim request has been
+ * honoured.
+ * \pre CPU lock held
+ */
+PRIVATE static inline NEEDS["context_base.h", "atomic.h", Kmem_alloc::drain_hot]
+Kmem_alloc::Hot_cpu *
+Kmem_alloc::hot_cpu()
+{
+  Hot_cpu *c = &_hot[current_cpu()];
+  unsigned long gen = access_once(&_hot_trim_gen);
+  if (EXPECT_FALSE(c->trim_gen != gen))
+    {
+      c->trim_gen = gen;
+      drain_hot(c);
+    }
+  return c;
+}
+
+PRIVATE static
+void *
+Kmem_alloc::hot_alloc(int cls, unsigned long size)
+{
+  auto guard = lock_guard(cpu_lock);
+  Hot_list *l = &hot_cpu()->list[cls];
+  if (EXPECT_TRUE(l->count != 0))
+    {
+      ++l->hits;
+      return l->pop();
+    }
+
+  ++l->misses;
+    {
+      auto guard = lock_guard(lock);
+      for (unsigned i = 0; i < Hot_batch; ++i)
+        {
+          void *b = a->alloc(size);
+          if (!b)
+            break;
+          l->push(b);
+        }
+    }
+
+  return l->count ? l->pop() : 0;
+}
+
+PRIVATE static
+void
+Kmem_alloc::hot_free(int cls, unsigned long size, void *block)
+{
+  auto guard = lock_guard(cpu_lock);
+  Hot_list *l = &hot_cpu()->list[cls];
+  l->push(block);
+  if (EXPECT_TRUE(l->count <= Hot_max))
+    return;
+
+  auto guard2 = lock_guard(lock);
+  for (unsigned i = 0; i < Hot_batch; ++i)
+    a->free(l->pop(), size);
+}
+
+/**
+ * Reserve Large_pool_blocks blocks of the largest buddy size.
+ * \return true if the pool is full.
+ * \pre lock held
+ */
+PRIVATE static
+bool
+Kmem_alloc::fill_large_pool_locked()
+{
+  while (_large_pool_blocks < Large_pool_blocks)
+    {
+      Free_block *b = (Free_block *)a->alloc(Alloc::Max_size);
+      if (!b)
+        return false;
+
+      b->next = _large_pool;
+      _large_pool = b;
+      ++_large_pool_blocks;
+    }
+  return true;
+}
+
+PRIVATE static
+void
+Kmem_alloc::fill_large_pool()
+{
+  auto guard = lock_guard(lock);
+  fill_large_pool_locked();
+}
+
+/**
+ * Give one reserved large block back to the buddy allocator.
+ * \pre lock held
+ */
+PRIVATE static
+bool
+Kmem_alloc::release_large_block_locked()
+{
+  Free_block *b = _large_pool;
+  if (!b)
+    return false;
+
+  _large_pool = b->next;
+  --_large_pool_blocks;
+  ++_large_pool_used;
+  a->free(b, Alloc::Max_size);
+  return true;
+}
+
+PRIVATE static
+void *
+Kmem_alloc::alloc_desperate(unsigned long size)
+{
+  // make every CPU return its hot blocks on its next allocation
+  write_now(&_hot_trim_gen, _hot_trim_gen + 1);
+
+    {
+      auto guard = lock_guard(cpu_lock);
+      hot_cpu();
+    }
+
+  void *ret;
+    {
+      auto guard = lock_guard(lock);
+      ret = a->alloc(size);
+      // only large blocks may use the reserve
+      if (!ret && size > 2 * Config::PAGE_SIZE && release_large_block_locked())
+        ret = a->alloc(size);
+    }
+
+  if (ret)
+    return ret;
+
+  Kmem_alloc_reaper::morecore (/* desperate= */ true);
+
+  auto guard = lock_guard(lock);
+  return a->alloc(size);
+}
+
 PUBLIC 
 void *
 Kmem_alloc::unaligned_alloc(unsigned long size)
@@ -150,19 +395,18 @@ Kmem_alloc::unaligned_alloc(unsigned long size)
   assert(size >=8 /*NEW INTERFACE PARANIOIA*/);
   void* ret;
 
-  {
-    auto guard = lock_guard(lock);
-    ret = a->alloc(size);
-  }
-
-  if (!ret)
+  int cls = hot_class(size);
+  if (cls >= 0)
+    ret = hot_alloc(cls, size);
+  else
     {
-      Kmem_alloc_reaper::morecore (/* desperate= */ true);
-
       auto guard = lock_guard(lock);
       ret = a->alloc(size);
     }
 
+  if (!ret)
+    ret = alloc_desperate(size);
+
   return ret;
 }
 
@@ -171,10 +415,57 @@ void
 Kmem_alloc::unaligned_free(unsigned long size, void *page)
 {
   assert(size >=8 /*NEW INTERFACE PARANIOIA*/);
+  int cls = hot_class(size);
+  if (cls >= 0)
+    {
+      hot_free(cls, size, page);
+      return;
+    }
+
   auto guard = lock_guard(lock);
   a->free(page, size);
+
+  // large frees may let us take back what the reserve lent out
+  if (EXPECT_FALSE(_large_pool_blocks < Large_pool_blocks))
+    fill_large_pool_locked();
+}
+
+/**
+ * Hot list statistics of one CPU, for JDB.
+ */
+PUBLIC static
+Kmem_alloc::Hot_stats
+Kmem_alloc::hot_stats(Cpu_number cpu, unsigned cls)
+{
+  Hot_list const *l = &_hot[cpu].list[cls];
+  Hot_stats s;
+  s.hits = l->hits;
+  s.misses = l->misses;
+  s.count = l->count;
+  return s;
 }
 
+/**
+ * Number of free buddy blocks of size Alloc::Min_size << size_index.
+ */
+PUBLIC static
+unsigned long
+Kmem_alloc::free_blocks(unsigned size_index)
+{ return a->free_blocks(size_index); }
+
+PUBLIC static inline
+unsigned
+Kmem_alloc::large_pool_blocks()
+{ return _large_pool_blocks; }
+
+/**
+ * How often the large-block reserve had to serve an allocation.
+ */
+PUBLIC static inline
+unsigned long
+Kmem_alloc::large_pool_used()
+{ return _large_pool_used; }
+
 
 PRIVATE static FIASCO_INIT
 unsigned long
@@ -0,0 +1,281 @@
+INTERFACE:
+
+#include "jdb_ktrace.h"
+#include "types.h"
+
+/**
+ * Per-CPU log2 latency histograms in the tbuf status page.
+ *
+ * Without CONFIG_JDB_LATENCY_HIST all hooks are empty inlines, so the
+ * lock and IPC paths do not pay for them.
+ */
+class Lat_hist
+{
+public:
+  typedef Unsigned32 Stamp;
+
+  /**
+   * Records the time from construction to destruction into one
+   * histogram, if active.
+   */
+  class Scope
+  {
+  public:
+    Scope(unsigned kind, bool active = true);
+    ~Scope();
+
+  private:
+    Stamp _start;
+    unsigned char _kind;
+    bool _active;
+  };
+};
+
+//---------------------------------------------------------------------------
+INTERFACE [lat_hist]:
+
+EXTENSION class Lat_hist
+{
+private:
+  typedef Unsigned32 Cpu_hist[Lat_hist_max][Lat_hist_buckets];
+
+  static Tracebuffer_status *_status;
+  /// histograms of the CPUs from Lat_hist_cpus on, exported by Jdb_tbuf
+  static Cpu_hist *_rest;
+  static Address _rest_size;
+};
+
+//---------------------------------------------------------------------------
+IMPLEMENTATION [!lat_hist]:
+
+PUBLIC static inline
+void
+Lat_hist::enable(Tracebuffer_status *)
+{}
+
+PUBLIC static inline
+void *
+Lat_hist::rest(Address *, Mword *)
+{ return 0; }
+
+PUBLIC static inline
+Lat_hist::Stamp
+Lat_hist::now()
+{ return 0; }
+
+PUBLIC static inline
+void
+Lat_hist::record(unsigned, Stamp)
+{}
+
+PUBLIC static inline
+void
+Lat_hist::spin_acquired(void const *, Stamp)
+{}
+
+PUBLIC static inline
+void
+Lat_hist::spin_released(void const *)
+{}
+
+PUBLIC static inline
+void
+Lat_hist::switch_begin()
+{}
+
+PUBLIC static inline
+void
+Lat_hist::switch_end()
+{}
+
+IMPLEMENT inline
+Lat_hist::Scope::Scope(unsigned, bool)
+{}
+
+IMPLEMENT inline
+Lat_hist::Scope::~Scope()
+{}
+
+//---------------------------------------------------------------------------
+IMPLEMENTATION [lat_hist]:
+
+#include <cstring>
+#include "config.h"
+#include "context_base.h"
+#include "kmem_alloc.h"
+#include "mem.h"
+
+Tracebuffer_status *Lat_hist::_status;
+Lat_hist::Cpu_hist *Lat_hist::_rest;
+Address Lat_hist::_rest_size;
+
+/**
+ * Per-CPU bookkeeping: the outermost spin lock held and the time it was
+ * taken, the start of a context switch in progress, and the histograms
+ * of the CPU. Only the CPU itself touches its entry.
+ */
+struct Lat_hist_cpu_state
+{
+  void const *spin_lock;
+  Lat_hist::Stamp spin_start;
+  Lat_hist::Stamp switch_start;
+  bool in_switch;
+  /// the histograms, 0 if there was no memory for them
+  Unsigned32 (*hist)[Lat_hist_buckets];
+};
+
+static Lat_hist_cpu_state lat_hist_state[Config::Max_num_cpus];
+
+/**
+ * Start recording into the given status page, and into pages of their own
+ * for the CPUs without a slot there. Called once the page is mapped,
+ * hooks before that are dropped.
+ */
+PUBLIC static
+void
+Lat_hist::enable(Tracebuffer_status *status)
+{
+  if (Config::Max_num_cpus > Lat_hist_cpus)
+    {
+      Address size = (Config::Max_num_cpus - Lat_hist_cpus) * sizeof(Cpu_hist);
+      size = (size + Config::PAGE_SIZE - 1) & ~(Config::PAGE_SIZE - 1);
+      _rest = (Cpu_hist *)Kmem_alloc::allocator()->unaligned_alloc(size);
+      if (_rest)
+        {
+          memset(_rest, 0, size);
+          _rest_size = size;
+        }
+    }
+
+  for (unsigned i = 0; i < Config::Max_num_cpus; ++i)
+    if (i < Lat_hist_cpus)
+      lat_hist_state[i].hist = status->lat_hist[i];
+    else if (_rest)
+      lat_hist_state[i].hist = _rest[i - Lat_hist_cpus];
+
+  Mem::mp_wmb();
+  _status = status;
+}
+
+/**
+ * The page-aligned histograms of the CPUs from Lat_hist_cpus on, 0 if
+ * there are none. Returns their size in size and the number of CPUs in
+ * cpus.
+ */
+PUBLIC static
+void *
+Lat_hist::rest(Address *size, Mword *cpus)
+{
+  if (!_rest)
+    return 0;
+
+  *size = _rest_size;
+  *cpus = Config::Max_num_cpus - Lat_hist_cpus;
+  return _rest;
+}
+
+PRIVATE static inline
+unsigned
+Lat_hist::bucket(Stamp delta)
+{
+  delta >>= Lat_hist_shift;
+  if (!delta)
+    return 0;
+
+  unsigned b = 32 - __builtin_clz(delta);
+  return b < Lat_hist_buckets ? b : Lat_hist_buckets - 1;
+}
+
+/**
+ * Account the time since start for the current CPU.
+ * \pre cpu lock held or running on the home CPU
+ */
+PUBLIC static
+void
+Lat_hist::record(unsigned kind, Stamp start)
+{
+  if (EXPECT_FALSE(!_status))
+    return;
+
+  unsigned cpu = cxx::int_value<Cpu_number>(current_cpu());
+  Unsigned32 (*hist)[Lat_hist_buckets] = lat_hist_state[cpu].hist;
+  if (EXPECT_TRUE(hist != 0))
+    ++hist[kind][bucket(now() - start)];
+}
+
+/**
+ * The spin lock lock was acquired, waiting started at start. Remembers
+ * the acquisition time if lock is the outermost lock on this CPU.
+ * \pre cpu lock held
+ */
+PUBLIC static
+void
+Lat_hist::spin_acquired(void const *lock, Stamp start)
+{
+  Stamp t = now();
+  record(Lat_hist_spin_wait, start);
+
+  Lat_hist_cpu_state *s = &lat_hist_state[cxx::int_value<Cpu_number>(current_cpu())];
+  if (!s->spin_lock)
+    {
+      s->spin_lock = lock;
+      s->spin_start = t;
+    }
+}
+
+/**
+ * The spin lock lock is about to be released.
+ * \pre cpu lock held
+ */
+PUBLIC static
+void
+Lat_hist::spin_released(void const *lock)
+{
+  Lat_hist_cpu_state *s = &lat_hist_state[cxx::int_value<Cpu_number>(current_cpu())];
+  if (s->spin_lock != lock)
+    return;
+
+  s->spin_lock = 0;
+  record(Lat_hist_spin_hold, s->spin_start);
+}
+
+/**
+ * A context switch starts on this CPU, the matching switch_end() runs
+ * in the context switched to.
+ * \pre cpu lock held
+ */
+PUBLIC static
+void
+Lat_hist::switch_begin()
+{
+  Lat_hist_cpu_state *s = &lat_hist_state[cxx::int_value<Cpu_number>(current_cpu())];
+  s->in_switch = true;
+  s->switch_start = now();
+}
+
+/**
+ * \pre cpu lock held
+ */
+PUBLIC static
+void
+Lat_hist::switch_end()
+{
+  Lat_hist_cpu_state *s = &lat_hist_state[cxx::int_value<Cpu_number>(current_cpu())];
+  if (!s->in_switch)
+    return;
+
+  s->in_switch = false;
+  record(Lat_hist_context_switch, s->switch_start);
+}
+
+IMPLEMENT
+Lat_hist::Scope::Scope(unsigned kind, bool active)
+: _start(active ? now() : 0), _kind(kind), _active(active)
+{}
+
+IMPLEMENT
+Lat_hist::Scope::~Scope()
+{
+  if (_active)
+    record(_kind, _start);
+}
@@ -43,6 +43,7 @@
   BEGIN_LOG_EVENT(name, sc, fmt)                                        \
     if (cond)                                                           \
       {                                                                 \
+        auto guard = lock_guard(cpu_lock);                              \
         fmt *l = Jdb_tbuf::new_entry<fmt>();                            \
         l->set_global(__do_log__, ctx, Proc::program_counter());        \
         {code;}                                                         \
@@ -129,6 +130,15 @@
 #define CNT_IO_FAULT            Jdb_tbuf::status()->kerncnts[Kern_cnt_io_fault]++;
 #define CNT_SCHEDULE            Jdb_tbuf::status()->kerncnts[Kern_cnt_schedule]++;
 #define CNT_EXC_IPC             Jdb_tbuf::status()->kerncnts[Kern_cnt_exc_ipc]++;
+#define CNT_DRQ_IPI_SAVED       Jdb_tbuf::status()->kerncnts[Kern_cnt_drq_ipi_saved]++;
+#define CNT_DRQ_BATCH(n)                                                \
+  do {                                                                  \
+    Jdb_tbuf::status()->kerncnts[Kern_cnt_drq_batches]++;               \
+    Jdb_tbuf::status()->kerncnts[Kern_cnt_drq_batch_items] += (n);      \
+  } while (0)
+#define CNT_FPU_TRAP            Jdb_tbuf::status()->kerncnts[Kern_cnt_fpu_trap]++;
+#define CNT_FPU_EAGER           Jdb_tbuf::status()->kerncnts[Kern_cnt_fpu_eager]++;
+#define CNT_FPU_EAGER_DROP      Jdb_tbuf::status()->kerncnts[Kern_cnt_fpu_eager_drop]++;
 
 // FIXME: currently unused entries below
 #define CNT_SHORTCUT_FAILED     Jdb_tbuf::status()->kerncnts[Kern_cnt_shortcut_failed]++;
@@ -146,6 +156,11 @@
 #define CNT_IO_FAULT		do { } while (0)
 #define CNT_SCHEDULE		do { } while (0)
 #define CNT_EXC_IPC             do { } while (0)
+#define CNT_DRQ_IPI_SAVED       do { } while (0)
+#define CNT_DRQ_BATCH(n)        do { } while (0)
+#define CNT_FPU_TRAP            do { } while (0)
+#define CNT_FPU_EAGER           do { } while (0)
+#define CNT_FPU_EAGER_DROP      do { } while (0)
 
 // FIXME: currently unused entries below
 #define CNT_SHORTCUT_FAILED	do { } while (0)
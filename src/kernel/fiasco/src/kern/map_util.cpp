@@ -70,12 +70,30 @@ struct Auto_tlb_flush<Mem_space>
       }
   }
 
+  /// Can all spaces postpone their flush on `cpu`?
+  bool defer_flush(Cpu_number cpu)
+  {
+    if (all)
+      return false;
+
+    for (unsigned i = 0; i < N_spaces && spaces[i]; ++i)
+      if (!spaces[i]->tlb_defer_flush(cpu))
+        return false;
+
+    return true;
+  }
+
   void global_flush()
   {
     if (empty)
       return;
 
-    Context::cpu_call_many(Context::active_tlb(), [this](Cpu_number) {
+    Cpu_mask cpus = Context::active_tlb();
+    for (Cpu_number n = Cpu_number::first(); n < Config::max_num_cpus(); ++n)
+      if (cpus.get(n) && defer_flush(n))
+        cpus.clear(n);
+
+    Context::cpu_call_many(cpus, [this](Cpu_number) {
       this->do_flush();
       return false;
     });
@@ -88,6 +106,25 @@ struct Auto_tlb_flush<Mem_space>
 struct Mapping_type_t;
 typedef cxx::int_type<unsigned, Mapping_type_t> Mapping_type;
 
+/// log2 of the max. number of pages revoked under one frame lock
+enum { Unmap_chunk_order = 8 };
+
+/**
+ * Max. size of the part of a page that unmap() revokes while holding the
+ * page's mapping-tree lock, 0 for no limit.
+ */
+template< typename SPACE >
+inline
+typename SPACE::V_pfc
+unmap_chunk()
+{ return typename SPACE::V_pfc(0); }
+
+template<>
+inline
+Mem_space::V_pfc
+unmap_chunk<Mem_space>()
+{ return Mem_space::V_pfc(1) << Mem_space::V_order(Unmap_chunk_order); }
+
 template< typename SPACE, typename M, typename O >
 inline
 L4_fpage::Rights
@@ -680,6 +717,7 @@ unmap(MAPDB* mapdb, SPACE* space, Space *space_id,
   V_pfn page_address;
 
   bool const full_flush = SPACE::is_full_flush(rights);
+  V_pfc const chunk = unmap_chunk<SPACE>();
 
   // iterate over all pages in "space"'s page table that are mapped
   // into the specified region
@@ -718,43 +756,71 @@ unmap(MAPDB* mapdb, SPACE* space, Space *space_id,
       // all pages shall be handled by our mapping data base
       assert_kdb (mapdb->valid_address(SPACE::to_pfn(phys)));
 
-      Mapping *mapping;
-      Frame mapdb_frame;
-
-      if (! mapdb->lookup(space_id, SPACE::to_pfn(page_address), SPACE::to_pfn(phys),
-                          &mapping, &mapdb_frame))
-        // someone else unmapped faster
-        continue;		// skip
-
+      // Revoke large pages in chunks.  The mapping-tree lock of the page
+      // is dropped between two chunks, so that page faults and map
+      // operations on the same frame from other CPUs, as well as
+      // preemption, do not have to wait for the whole revocation.  The
+      // page itself is removed from "space" with the last chunk.
+      V_pfn const stop = end < page_address + phys_size
+                       ? end : page_address + phys_size;
       L4_fpage::Rights page_rights(0);
 
-      // Delete from this address space
-      if (me_too)
+      for (V_pfn chunk_start = address;;)
         {
-          page_rights |=
-            space->v_delete(address, phys_order, rights);
+          V_pfn chunk_end = stop;
+          if (chunk != V_pfc(0) && stop - chunk_start > chunk)
+            chunk_end = chunk_start + chunk;
 
-          tlb.add_page(space, address, phys_order);
-        }
+          bool const last = chunk_end == stop;
 
-      MAPDB::foreach_mapping(mapdb_frame, mapping, SPACE::to_pfn(address), SPACE::to_pfn(end),
-          [&page_rights, rights, full_flush, &tlb](typename MAPDB::Mapping *m, typename MAPDB::Order size)
-          {
-            page_rights |= v_delete<SPACE>(m, size, rights, full_flush, tlb);
-          });
+          // The last pass of a self unmap covers the whole range again:
+          // children attached to the revoked chunks while the frame was
+          // unlocked must lose their pages before the flush frees them.
+          V_pfn const rev_start = me_too && last ? address : chunk_start;
 
-      flushed_rights |= page_rights;
+          Mapping *mapping;
+          Frame mapdb_frame;
 
-      // Store access attributes for later retrieval
-      save_access_flags<MAPDB>(space, page_address, me_too, mapping, mapdb_frame, page_rights);
+          if (! mapdb->lookup(space_id, SPACE::to_pfn(page_address), SPACE::to_pfn(phys),
+                              &mapping, &mapdb_frame))
+            // someone else unmapped faster
+            break;		// skip
+
+          // Delete from this address space
+          if (me_too && last)
+            {
+              page_rights |=
+                space->v_delete(address, phys_order, rights);
+
+              tlb.add_page(space, address, phys_order);
+            }
 
-      if (full_flush)
-        mapdb->flush(mapdb_frame, mapping, mask, SPACE::to_pfn(address), SPACE::to_pfn(end));
+          MAPDB::foreach_mapping(mapdb_frame, mapping, SPACE::to_pfn(rev_start), SPACE::to_pfn(chunk_end),
+              [&page_rights, rights, full_flush, &tlb](typename MAPDB::Mapping *m, typename MAPDB::Order size)
+              {
+                page_rights |= v_delete<SPACE>(m, size, rights, full_flush, tlb);
+              });
 
-      if (full_flush)
-        Map_traits<SPACE>::free_object(phys, reap_list);
+          if (last)
+            // Store access attributes for later retrieval
+            save_access_flags<MAPDB>(space, page_address, me_too, mapping, mapdb_frame, page_rights);
 
-      mapdb->free(mapdb_frame);
+          if (full_flush)
+            mapdb->flush(mapdb_frame, mapping, last ? mask : mask.children(),
+                         SPACE::to_pfn(rev_start), SPACE::to_pfn(chunk_end));
+
+          if (full_flush && last)
+            Map_traits<SPACE>::free_object(phys, reap_list);
+
+          mapdb->free(mapdb_frame);
+
+          if (last)
+            break;
+
+          chunk_start = chunk_end;
+        }
+
+      flushed_rights |= page_rights;
     }
 
   return flushed_rights;
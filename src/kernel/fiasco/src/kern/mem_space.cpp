@@ -335,3 +335,15 @@ PUBLIC inline
 bool
 Mem_space::io_lookup (Address)
 { return false; }
+
+//---------------------------------------------------------------------------
+IMPLEMENTATION [!mips32]:
+
+/**
+ * Postpone flushing the TLB entries of this space on `cpu`.
+ * \return false, `cpu` always has to flush right away.
+ */
+PUBLIC inline
+bool
+Mem_space::tlb_defer_flush(Cpu_number)
+{ return false; }
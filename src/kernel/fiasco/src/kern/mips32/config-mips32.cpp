@@ -24,12 +24,11 @@ public:
     PAGE_SHIFT = ARCH_PAGE_SHIFT,
     PAGE_SIZE  = 1 << PAGE_SHIFT,
     PAGE_MASK  = ~(PAGE_SIZE - 1),
-    SUPERPAGE_SHIFT = 22,
+    // one first-level page-table entry, see Ptab_traits
+    SUPERPAGE_SHIFT = PAGE_SHIFT + 10,
     SUPERPAGE_SIZE  = 1 << SUPERPAGE_SHIFT,
     SUPERPAGE_MASK  = ~(SUPERPAGE_SIZE -1),
 
-    // XXXKYMA: No large pages/TLBs yet, update paging-mips32 when enabled
-    have_superpages = 0,
     hlt_works_ok = 1,
     Irq_shortcut = 1,
   };
@@ -83,6 +82,24 @@ private:
   static void init_arch_platform();
 };
 
+//---------------------------------------------------------------------------
+INTERFACE [mips32 && !mips_superpages]:
+
+EXTENSION class Config
+{
+public:
+  enum { have_superpages = 0 };
+};
+
+//---------------------------------------------------------------------------
+INTERFACE [mips32 && mips_superpages]:
+
+EXTENSION class Config
+{
+public:
+  enum { have_superpages = 1 };
+};
+
 
 //---------------------------------------------------------------------------
 IMPLEMENTATION [mips32]:
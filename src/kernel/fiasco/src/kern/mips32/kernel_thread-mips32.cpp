@@ -50,3 +50,43 @@ Kernel_thread::boot_app_cpus()
   extern char _tramp_mp_init_stack_top[];
   Platform_control::boot_secondary((Address)_tramp_mp_entry, (Address)_tramp_mp_init_stack_top);
 }
+
+//--------------------------------------------------------------------------
+IMPLEMENTATION [mips32 && tickless]:
+
+#include "processor.h"
+#include "rcupdate.h"
+#include "timer.h"
+
+extern "C" void mips_tickless_wait();
+
+/**
+ * Called by the interrupt entry, before the handler, for an interrupt
+ * that ends mips_tickless_wait().
+ */
+extern "C"
+void
+mips_tickless_wakeup()
+{
+  Cpu_number cpu = current_cpu();
+  Rcu::leave_idle(cpu);
+  Timer::restart_tick(cpu);
+}
+
+/**
+ * Wait with interrupts enabled like Proc::halt(), not every core leaves
+ * the wait state on a masked interrupt. An interrupt that slips in
+ * between the checks in idle_op() and the wait is not slept over, the
+ * interrupt entry skips the wait then (see exception.S).
+ */
+PROTECTED inline
+void
+Kernel_thread::arch_tickless_idle(Cpu_number)
+{
+  mips_tickless_wait();
+}
+
+PROTECTED inline NEEDS["processor.h"]
+void
+Kernel_thread::arch_idle(Cpu_number)
+{ Proc::halt(); }
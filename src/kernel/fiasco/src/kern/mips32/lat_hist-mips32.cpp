@@ -0,0 +1,11 @@
+IMPLEMENTATION [mips32 && lat_hist]:
+
+#include "mipsregs.h"
+
+/**
+ * CP0 Count, runs at half the pipeline clock on most cores.
+ */
+PUBLIC static
+Lat_hist::Stamp
+Lat_hist::now()
+{ return read_c0_count(); }
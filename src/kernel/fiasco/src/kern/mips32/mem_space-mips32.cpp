@@ -7,9 +7,11 @@
 INTERFACE [mips32]:
 
 #include "auto_quota.h"
+#include "cpu_mask.h"
 #include "kmem.h"               // for "_unused_*" virtual memory regions
 #include "member_offs.h"
 #include "paging.h"
+#include "tlb_entry.h"
 #include "types.h"
 #include "ram_quota.h"
 
@@ -58,9 +60,12 @@ IMPLEMENTATION [mips32]:
 
 #include "atomic.h"
 #include "config.h"
+#include "cpu_lock.h"
 #include "globals.h"
 #include "kdb_ke.h"
 #include "l4_types.h"
+#include "lock_guard.h"
+#include "mem.h"
 #include "panic.h"
 #include "paging.h"
 #include "kmem.h"
@@ -122,14 +127,30 @@ Mem_space::is_full_flush(L4_fpage::Rights rights)
 
 // Mapping utilities
 
-PUBLIC inline NEEDS["mem_unit.h"]
+PUBLIC inline NEEDS["mem_unit.h", "cpu_lock.h", "lock_guard.h",
+                     Mem_space::drop_asid]
 void
 Mem_space::tlb_flush(bool force = false)
 {
   if (!Have_asids)
     Mem_unit::tlb_flush();
-  else if (force && c_asid() != Mem_unit::Asid_invalid)
-    Mem_unit::tlb_flush(c_asid());
+  else if (force)
+    {
+      auto guard = lock_guard(cpu_lock);
+      Cpu_number cpu = current_cpu();
+      if (_current.cpu(cpu) != this)
+        {
+          // not active here, a fresh ASID is cheaper than a TLB walk
+          drop_asid(cpu);
+          _flush_pending.atomic_clear(cpu);
+        }
+      else
+        {
+          _flush_pending.atomic_clear(cpu);
+          if (c_asid() != Mem_unit::Asid_invalid)
+            Mem_unit::tlb_flush(c_asid());
+        }
+    }
 
   // else do nothing, we manage ASID local flushes in v_* already
   // Mem_unit::tlb_flush();
@@ -389,7 +410,7 @@ Mem_space::v_pagein_kmem(Vaddr virt)
 PUBLIC
 Mem_space::~Mem_space()
 {
-  reset_asid();
+  // our ASIDs are not reused before the next generation, nothing to do
   if (_dir)
     {
 
@@ -447,97 +468,140 @@ EXTENSION class Mem_space
 public:
   enum { Have_asids = 1 };
 private:
-  typedef Per_cpu_array<unsigned long> Asid_array;
-  Asid_array _asid;
+  enum : Mword
+  {
+    Asid_mask    = Tlb_entry::AsidMask,
+    /// the bits above Asid_mask count ASID generations
+    Asid_version = Asid_mask + 1,
+  };
 
-  static Per_cpu<unsigned char> _next_free_asid;
-  static Per_cpu<Mem_space *[256]>   _active_asids;
+  /// ASID and generation of this space per CPU, see _asid_cache. 64 bits,
+  /// so that the generation never wraps around to a stale ASID of a space
+  typedef Per_cpu_array<Unsigned64> Asid_array;
+  Asid_array _asid;
+  /// CPUs that may hold TLB entries tagged with our ASID
+  Cpu_mask _tlb_cpus;
+  /// CPUs that must drop our ASID before they use it again
+  Cpu_mask _flush_pending;
+
+  /**
+   * Last ASID handed out on a CPU, including the current generation.
+   * ASIDs are never reused within a generation, so a space gets rid of
+   * its TLB entries by simply dropping its ASID.
+   */
+  static Per_cpu<Unsigned64> _asid_cache;
 };
 
-PRIVATE inline static
-unsigned long
-Mem_space::next_asid(Cpu_number cpu)
-{
-  if (_next_free_asid.cpu(cpu) == 0)
-    ++_next_free_asid.cpu(cpu);
-  return _next_free_asid.cpu(cpu)++;
-}
-
-DEFINE_PER_CPU Per_cpu<unsigned char>    Mem_space::_next_free_asid;
-DEFINE_PER_CPU Per_cpu<Mem_space *[256]> Mem_space::_active_asids;
+DEFINE_PER_CPU Per_cpu<Unsigned64> Mem_space::_asid_cache;
 
 PRIVATE inline
 void
-Mem_space::asid(unsigned long a)
+Mem_space::asid(Unsigned64 a)
 {
   for (Asid_array::iterator i = _asid.begin(); i != _asid.end(); ++i)
     *i = a;
 }
 
-PUBLIC inline
+PRIVATE inline
+bool
+Mem_space::asid_valid(Cpu_number cpu) const
+{
+  return ((access_once(&_asid[cpu]) ^ _asid_cache.cpu(cpu))
+          & ~Unsigned64(Asid_mask)) == 0;
+}
+
+PUBLIC inline NEEDS[Mem_space::asid_valid]
 unsigned long
 Mem_space::c_asid() const
-{ return _asid[current_cpu()]; }
+{
+  Cpu_number cpu = current_cpu();
+  if (EXPECT_FALSE(!asid_valid(cpu)))
+    return Mem_unit::Asid_invalid;
 
-PRIVATE inline NEEDS[Mem_space::next_asid, "types.h"]
+  return _asid[cpu] & Asid_mask;
+}
+
+/**
+ * Hand out the next ASID on `cpu`, starting a new generation and
+ * flushing the local TLB when the current generation is used up.
+ * \pre cpu_lock held, `cpu` is the current CPU.
+ */
+PRIVATE inline NEEDS["mem.h", "mem_unit.h"]
+void
+Mem_space::new_asid(Cpu_number cpu)
+{
+  Unsigned64 a = ++_asid_cache.cpu(cpu);
+  if (EXPECT_FALSE((a & Asid_mask) == 0))
+    {
+      // never enter the generation of Asid_invalid
+      if (EXPECT_FALSE(a == (Unsigned64(Mem_unit::Asid_invalid)
+                             & ~Unsigned64(Asid_mask))))
+        a += Asid_version;
+
+      Mem_unit::tlb_flush();
+      // ASID 0 is never handed out
+      _asid_cache.cpu(cpu) = ++a;
+    }
+
+  _asid[cpu] = a;
+  _tlb_cpus.atomic_set(cpu);
+  // publish _tlb_cpus before we load any page-table entry
+  Mem::mp_mb();
+}
+
+/**
+ * Forget our ASID on `cpu`, TLB entries tagged with it are never
+ * matched again.
+ * \pre cpu_lock held, `cpu` is the current CPU.
+ */
+PRIVATE inline
+void
+Mem_space::drop_asid(Cpu_number cpu)
+{
+  _asid[cpu] = Mem_unit::Asid_invalid;
+  _tlb_cpus.atomic_clear(cpu);
+}
+
+PRIVATE inline NEEDS[Mem_space::new_asid, Mem_space::drop_asid,
+                     Mem_space::asid_valid]
 unsigned long
 Mem_space::asid()
 {
   Cpu_number cpu = current_cpu();
-  if (EXPECT_FALSE(_asid[cpu] == Mem_unit::Asid_invalid))
-    {
-      // FIFO ASID replacement strategy
-      unsigned char new_asid = next_asid(cpu);
-      Mem_space **bad_guy = &_active_asids.cpu(cpu)[new_asid];
-      while (Mem_space *victim = access_once(bad_guy))
-        {
-          // need ASID replacement
-          if (victim == current_mem_space(cpu))
-            {
-              // do not replace the ASID of the current space
-              new_asid = next_asid(cpu);
-              bad_guy = &_active_asids.cpu(cpu)[new_asid];
-              continue;
-            }
-
-          //LOG_MSG_3VAL(current(), "ASIDr", new_asid, (Mword)*bad_guy, (Mword)this);
-
-          // If the victim is valid and we get a 1 written to the ASID array
-          // then we have to reset the ASID of our victim, else the
-          // reset_asid function is currently resetting the ASIDs of the
-          // victim on a different CPU.
-          if (victim != reinterpret_cast<Mem_space*>(~0UL) &&
-              mp_cas(bad_guy, victim, reinterpret_cast<Mem_space*>(1)))
-            write_now(&victim->_asid[cpu], (Mword)Mem_unit::Asid_invalid);
-          break;
-        }
+  if (EXPECT_FALSE(_flush_pending.atomic_get_and_clear(cpu)))
+    drop_asid(cpu);
 
-      _asid[cpu] = new_asid;
-      Mem_unit::tlb_flush(new_asid);
-      write_now(bad_guy, this);
-    }
+  if (EXPECT_FALSE(!asid_valid(cpu)))
+    new_asid(cpu);
 
   //LOG_MSG_3VAL(current(), "ASID", (Mword)this, _asid[cpu], (Mword)__builtin_return_address(0));
-  return _asid[cpu];
+  return _asid[cpu] & Asid_mask;
 };
 
-PRIVATE inline
-void
-Mem_space::reset_asid()
+/**
+ * Flush our TLB entries on `cpu` lazily if possible.
+ *
+ * Unless the space is currently active on `cpu` the flush is recorded
+ * and done when `cpu` switches to this space the next time, by picking
+ * a fresh ASID.
+ *
+ * \return true if the flush was deferred, false if `cpu` must flush
+ *         its TLB itself.
+ */
+PUBLIC inline NEEDS["mem.h"]
+bool
+Mem_space::tlb_defer_flush(Cpu_number cpu)
 {
-  for (Cpu_number i = Cpu_number::first(); i < Config::max_num_cpus(); ++i)
-    {
-      unsigned long asid = access_once(&_asid[i]);
-      if (asid == Mem_unit::Asid_invalid)
-        continue;
-
-      Mem_space **a = &_active_asids.cpu(i)[asid];
-      if (!mp_cas(a, this, reinterpret_cast<Mem_space*>(~0UL)))
-        // It could be our ASID is in the process of being preempted,
-        // so wait until this is done.
-        while (access_once(a) == reinterpret_cast<Mem_space*>(1))
-          ;
-    }
+  // order the page-table update before the _tlb_cpus load, pairs with the
+  // barrier in new_asid()
+  Mem::mp_mb();
+  if (!_tlb_cpus.get(cpu))
+    return true;
+
+  _flush_pending.atomic_set(cpu);
+  // pairs with the barrier in make_current()
+  Mem::mp_mb();
+  return access_once(&_current.cpu(cpu)) != this;
 }
 
 /**
@@ -551,10 +615,14 @@ Mem_space::reset_asid()
  * leaving a value of Asid_invalid confuses Fiasco.
  *
  */
-IMPLEMENT inline
+IMPLEMENT inline NEEDS["mem.h"]
 void
 Mem_space::make_current()
 {
+  // become current before looking at _flush_pending, see tlb_defer_flush()
+  _current.current() = this;
+  Mem::mp_mb();
+
   Mem_unit::change_asid(asid());
   if (EXPECT_FALSE(_is_vmspace)) {
     if (_use_vzguestid) {
@@ -564,8 +632,6 @@ Mem_space::make_current()
       Mem_unit::local_flush_guesttlb_all();
     }
   }
-
-  _current.current() = this;
 }
 
 EXTENSION class Mem_space
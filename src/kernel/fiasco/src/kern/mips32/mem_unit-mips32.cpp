@@ -118,6 +118,63 @@ out:
   EXIT_CRITICAL(flags);
 }
 
+/**
+ * Invalidate all non-global TLB entries of `asid` that overlap the
+ * naturally aligned region [`start`, `start` + `mask`].
+ *
+ * Needed before loading a large-page entry, because the TLB must never
+ * hold two entries matching the same address.
+ */
+PUBLIC static
+void Mem_unit::tlb_flush_range(Address start, Mword mask, unsigned long asid)
+{
+  if (asid == Asid_invalid)
+    return;
+
+  Proc::Status flags;
+  Mword old_entryhi;
+  Mword old_pagemask;
+  Signed32 tlbsize = Cpu::tlbsize();
+  Signed32 idx;
+
+  ENTER_CRITICAL(flags);
+  old_entryhi = read_c0_entryhi();
+  old_pagemask = read_c0_pagemask();
+
+  for (idx = read_c0_wired(); idx < tlbsize; idx++)
+    {
+      write_c0_index(idx);
+      mtc0_tlbw_hazard();
+      tlb_read();
+      tlbw_use_hazard();
+      Mword entryhi = read_c0_entryhi();
+      Mword span = read_c0_pagemask() | ~Tlb_entry::VPN2Mask;
+
+      if ((entryhi & Tlb_entry::AsidMask) != asid
+          || (read_c0_entrylo0() & Tlb_entry::Global)
+          || (read_c0_entrylo1() & Tlb_entry::Global))
+        continue;
+
+      // two naturally aligned regions overlap iff they agree above the
+      // larger of both masks
+      if (((entryhi ^ start) & ~(span | mask) & Tlb_entry::VPN2Mask) != 0)
+        continue;
+
+      write_c0_entryhi(UNIQUE_ENTRYHI(idx));
+      write_c0_entrylo0(0);
+      write_c0_entrylo1(0);
+      write_c0_pagemask(0);
+      write_c0_index(idx);
+      mtc0_tlbw_hazard();
+      tlb_write_indexed();
+    }
+
+  tlbw_use_hazard();
+  write_c0_pagemask(old_pagemask);
+  write_c0_entryhi(old_entryhi);
+  EXIT_CRITICAL(flags);
+}
+
 PUBLIC static
 void Mem_unit::tlb_flush(void)
 {
@@ -7,6 +7,7 @@
 INTERFACE [mips32]:
 
 #include "types.h"
+#include "config.h"
 #include "mem_unit.h"
 #include "ptab_base.h"
 #include "tlb_entry.h"
@@ -82,19 +83,15 @@ public:
 
 INTERFACE [mips32 && pagesize_4k]:
 
-typedef Ptab::List< Ptab::Traits<Unsigned32, 22, 10, false>,
+typedef Ptab::List< Ptab::Traits<Unsigned32, 22, 10, Config::have_superpages>,
                     Ptab::Traits<Unsigned32, 12, 10, true> > Ptab_traits;
 
 INTERFACE [mips32 && pagesize_16k]:
 
 // next_level must also be changed to 256Byte second level table i.e. 8 bit
-typedef Ptab::List< Ptab::Traits<Unsigned32, 24, 8, false>,
+typedef Ptab::List< Ptab::Traits<Unsigned32, 24, 8, Config::have_superpages>,
                     Ptab::Traits<Unsigned32, 14, 10, true> > Ptab_traits;
 
-// Kyma: If Config::have_superpages then set leaf to true.
-//typedef Ptab::List< Ptab::Traits<Unsigned32, 22, 10, true>,
-//                    Ptab::Traits<Unsigned32, 12, 10, true> > Ptab_traits;
-
 INTERFACE [mips32]:
 typedef Ptab::Shift<Ptab_traits, Virt_addr::Shift>::List Ptab_traits_vpn;
 typedef Ptab::Page_addr_wrap<Page_number, Virt_addr::Shift> Ptab_va_vpn;
@@ -394,8 +391,24 @@ Pte_ptr::update_tlb(Address virt, Mword asid, Mword vzguestid)
   e.pagemask(page_mask());
 
   Pte_pair_raw* pte_pair = pte_pair_boundary();
-  e.entrylo0(pte_pair->pte_even, pte_pair->pte_even | (is_global() ? Global : 0));
-  e.entrylo1(pte_pair->pte_odd, pte_pair->pte_odd | (is_global() ? Global : 0));
+  Mword even = pte_pair->pte_even;
+  Mword odd = pte_pair->pte_odd;
+
+  if (level < Pdir::Depth)
+    {
+      // a superpage pairs two first-level entries, the buddy may
+      // point to a page table and must not be loaded then
+      if (!(even & Pse_bit))
+        even = 0;
+      if (!(odd & Pse_bit))
+        odd = 0;
+
+      if (!is_global())
+        Mem_unit::tlb_flush_range(virt & ~page_mask(), page_mask(), asid);
+    }
+
+  e.entrylo0(even, even | (is_global() ? Global : 0));
+  e.entrylo1(odd, odd | (is_global() ? Global : 0));
   e.guestctl1(vzguestid, 0);
 
   //printf("update_tlb: virt %lx, pte_even %lx, pte_odd %lx (this->pte %p)\n",
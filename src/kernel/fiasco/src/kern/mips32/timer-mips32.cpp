@@ -33,16 +33,17 @@ IMPLEMENTATION [mips32]:
 
 Unsigned32 Timer::mips_timer_intv;
 
-IMPLEMENT inline NEEDS ["kip.h", "config.h", <cstdio>, "timer.h"]
+IMPLEMENT inline NEEDS ["kip.h", "config.h", <cstdio>, "timer.h",
+                        Timer::start_tick]
 void
-Timer::init(Cpu_number)
+Timer::init(Cpu_number cpu)
 {
   printf("Using MIPS count/compare for scheduling\n");
 
   init_system_clock();
 
   mips_timer_intv = (Kip::k()->frequency_cpu * 1000)/Config::Scheduler_granularity;
-  update_timer(mips_timer_intv);
+  start_tick(cpu);
 }
 
 PUBLIC static inline NEEDS["irq_chip.h"]
@@ -50,16 +51,6 @@ Irq_chip::Mode
 Timer::irq_mode()
 { return Irq_chip::Mode::F_raising_edge; }
 
-PUBLIC static inline NEEDS["mipsregs.h", "timer.h"]
-void
-Timer::acknowledge()
-{ 
-  write_c0_compare(read_c0_compare());
-  back_to_back_c0_hazard();
-  update_timer(mips_timer_intv);
-  update_system_clock(current_cpu());
-}
-
 IMPLEMENT inline NEEDS ["kip.h"]
 void
 Timer::init_system_clock()
@@ -74,6 +65,32 @@ Timer::system_clock()
   return Kip::k()->clock;
 }
 
+IMPLEMENT inline NEEDS["mipsregs.h"]
+void
+Timer::update_timer(Unsigned64 wakeup)
+{
+  write_c0_compare(read_c0_count() + wakeup);
+  back_to_back_c0_hazard();
+}
+
+// ------------------------------------------------------------------------
+IMPLEMENTATION [mips32 && !tickless]:
+
+PRIVATE static inline
+void
+Timer::start_tick(Cpu_number)
+{ update_timer(mips_timer_intv); }
+
+PUBLIC static inline NEEDS["mipsregs.h", "timer.h"]
+void
+Timer::acknowledge()
+{ 
+  write_c0_compare(read_c0_compare());
+  back_to_back_c0_hazard();
+  update_timer(mips_timer_intv);
+  update_system_clock(current_cpu());
+}
+
 IMPLEMENT inline NEEDS ["config.h", "kip.h"]
 void
 Timer::update_system_clock(Cpu_number cpu)
@@ -84,10 +101,180 @@ Timer::update_system_clock(Cpu_number cpu)
   }
 }
 
-IMPLEMENT inline NEEDS["mipsregs.h"]
+// ------------------------------------------------------------------------
+INTERFACE [mips32 && tickless]:
+
+#include "per_cpu_data.h"
+
+EXTENSION class Timer
+{
+private:
+  /**
+   * Per-CPU tick bookkeeping. Compare values are kept aligned to the
+   * tick interval so that skipped ticks can be counted from the
+   * count register alone.
+   */
+  struct Tick_state
+  {
+    Unsigned32 last;        ///< count value of the last accounted tick
+    Unsigned64 wakeup;      ///< system clock of the programmed wakeup
+    bool stopped;
+    Unsigned32 uncharged;   ///< ticks acknowledged but not yet charged
+    Unsigned64 suppressed;
+  };
+
+  static Per_cpu<Tick_state> _tick;
+};
+
+// ------------------------------------------------------------------------
+IMPLEMENTATION [mips32 && tickless]:
+
+#include "context.h"
+
+DEFINE_PER_CPU Per_cpu<Timer::Tick_state> Timer::_tick;
+
+/**
+ * Program the compare register, never behind the counter as such a
+ * deadline would only fire after a full wrap.
+ */
+PRIVATE static inline NEEDS["mipsregs.h"]
 void
-Timer::update_timer(Unsigned64 wakeup)
+Timer::set_compare(Unsigned32 cmp)
 {
-  write_c0_compare(read_c0_count() + wakeup);
+  while ((Signed32)(cmp - read_c0_count()) <= 0)
+    cmp += mips_timer_intv;
+
+  write_c0_compare(cmp);
   back_to_back_c0_hazard();
 }
+
+PRIVATE static inline NEEDS["mipsregs.h", Timer::set_compare]
+void
+Timer::start_tick(Cpu_number cpu)
+{
+  Tick_state &t = _tick.cpu(cpu);
+  t.last = read_c0_count();
+  t.stopped = false;
+  set_compare(t.last + mips_timer_intv);
+}
+
+/**
+ * Account `n` elapsed ticks; the boot CPU advances the system clock.
+ */
+PRIVATE static inline NEEDS["config.h", "kip.h"]
+void
+Timer::account_ticks(Cpu_number cpu, Unsigned32 n)
+{
+  _tick.cpu(cpu).last += n * mips_timer_intv;
+  if (cpu == Cpu_number::boot_cpu())
+    Kip::k()->clock += (Unsigned64)n * Config::Scheduler_granularity;
+}
+
+PUBLIC static inline NEEDS["mipsregs.h", Timer::account_ticks,
+                           Timer::set_compare]
+void
+Timer::acknowledge()
+{
+  Cpu_number cpu = current_cpu();
+  Tick_state &t = _tick.cpu(cpu);
+  Unsigned32 n = (read_c0_count() - t.last) / mips_timer_intv;
+
+  if (t.stopped)
+    {
+      t.stopped = false;
+      if (n > 1)
+        t.suppressed += n - 1;
+    }
+
+  t.uncharged += n;
+  account_ticks(cpu, n);
+  set_compare(t.last + mips_timer_intv);
+}
+
+/**
+ * The clock is advanced in acknowledge() by the number of elapsed ticks.
+ */
+IMPLEMENT inline
+void
+Timer::update_system_clock(Cpu_number)
+{}
+
+IMPLEMENT
+bool
+Timer::stop_tick(Cpu_number cpu, Unsigned64 wakeup, bool busy)
+{
+  // The boot CPU advances the KIP clock, keep it ticking whenever
+  // someone else might look at the clock.
+  if (cpu == Cpu_number::boot_cpu() && (busy || Config::Max_num_cpus > 1))
+    return false;
+
+  Unsigned64 now = system_clock();
+  if (wakeup <= now + 2 * Config::Scheduler_granularity)
+    return false;
+
+  Unsigned64 ticks = (wakeup - now) / Config::Scheduler_granularity;
+  Unsigned32 max_ticks = 0x7fffffffU / mips_timer_intv;
+  if (ticks > max_ticks)
+    ticks = max_ticks;
+
+  Tick_state &t = _tick.cpu(cpu);
+  t.stopped = true;
+  t.wakeup = now + ticks * Config::Scheduler_granularity;
+  set_compare(t.last + (Unsigned32)ticks * mips_timer_intv);
+  return true;
+}
+
+IMPLEMENT
+void
+Timer::restart_tick(Cpu_number cpu)
+{
+  Tick_state &t = _tick.cpu(cpu);
+  if (!t.stopped)
+    return;
+
+  // an expired deadline leaves the timer interrupt pending,
+  // acknowledge() does the accounting then
+  if ((Signed32)(read_c0_count() - read_c0_compare()) >= 0)
+    return;
+
+  Unsigned32 n = (read_c0_count() - t.last) / mips_timer_intv;
+  t.stopped = false;
+  t.suppressed += n;
+  account_ticks(cpu, n);
+  set_compare(t.last + mips_timer_intv);
+
+  // the ticks belong to the thread that ran (or idled) without them,
+  // the next timer interrupt may already hit another one
+  if (!Config::Fine_grained_cputime)
+    current()->consume_time((Unsigned64)n * Config::Scheduler_granularity);
+}
+
+IMPLEMENT
+Unsigned64
+Timer::suppressed_ticks(Cpu_number cpu)
+{ return _tick.cpu(cpu).suppressed; }
+
+IMPLEMENT inline
+Unsigned32
+Timer::charge_ticks(Cpu_number cpu)
+{
+  Tick_state &t = _tick.cpu(cpu);
+  Unsigned32 n = t.uncharged;
+  t.uncharged = 0;
+  return n;
+}
+
+/**
+ * Something on `cpu` needs the tick at `wakeup` at the latest.
+ *
+ * Only the local CPU can be reprogrammed, timeouts are always
+ * enqueued on the CPU they belong to.
+ */
+PUBLIC static inline
+void
+Timer::tick_needed(Cpu_number cpu, Unsigned64 wakeup)
+{
+  Tick_state const &t = _tick.cpu(cpu);
+  if (EXPECT_FALSE(t.stopped) && wakeup < t.wakeup && cpu == current_cpu())
+    restart_tick(cpu);
+}
@@ -52,6 +52,7 @@ IMPLEMENTATION:
 #include <cassert>
 
 #include "atomic.h"
+#include "cap_cache.h"
 #include "config.h"
 #include "cpu.h"
 #include "kmem_alloc.h"
@@ -210,6 +211,7 @@ Obj_space_phys<SPACE>::v_delete(V_pfn virt, Page_order size,
         c->invalidate();
       else
 	c->del_rights(page_attribs);
+      Cap_cache::invalidate_all();
     }
 
   return L4_fpage::Rights(0);
@@ -237,6 +239,7 @@ Obj_space_phys<SPACE>::v_insert(Phys_addr phys, V_pfn const &virt, Page_order si
 	    return Obj::Insert_warn_exists;
 
 	  c->add_rights(page_attribs);
+	  Cap_cache::invalidate_all();
 	  return Obj::Insert_warn_attrib_upgrade;
 	}
       else
@@ -48,6 +48,7 @@ IMPLEMENTATION:
 #include <cassert>
 
 #include "atomic.h"
+#include "cap_cache.h"
 #include "config.h"
 #include "cpu.h"
 #include "kdb_ke.h"
@@ -256,6 +257,7 @@ Obj_space_virt<SPACE>::v_delete(V_pfn virt, Order size,
         c->invalidate();
       else
         c->del_rights(page_attribs & L4_fpage::Rights::CWSD());
+      Cap_cache::invalidate_all();
     }
 
   return L4_fpage::Rights(0);
@@ -301,6 +303,7 @@ Obj_space_virt<SPACE>::v_insert(Phys_addr phys, V_pfn const &virt, Order size,
 	    return Obj::Insert_warn_exists;
 
 	  c->add_rights(page_attribs);
+	  Cap_cache::invalidate_all();
 	  return Obj::Insert_warn_attrib_upgrade;
 	}
       else
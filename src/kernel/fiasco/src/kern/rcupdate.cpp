@@ -78,6 +78,15 @@ public:
     return *this;
   }
 
+  /// Dequeue the head item, keeping the tail valid for later appends.
+  Rcu_item *pop_front()
+  {
+    Rcu_item *i = Base::pop_front();
+    if (empty())
+      clear();
+    return i;
+  }
+
 private:
   friend class Jdb_rcupdate;
 };
@@ -95,9 +104,11 @@ public:
   bool _pending;        ///< wait for quiescent state
   bool _idle;
 
-  Rcu_batch _batch;
-  Rcu_list _n;
-  long _len;
+  Rcu_batch _batch;     ///< batch the current list waits for
+  Rcu_list _n;          ///< new callbacks, not yet assigned to a batch
+  long _len;            ///< number of callbacks in all lists
+  Rcu_batch _r_batch;   ///< batch the ready list waits for
+  Rcu_list _r;          ///< callbacks waiting for the batch after _batch
   Rcu_list _c;
   Rcu_list _d;
   Cpu_number _cpu;
@@ -117,6 +128,8 @@ private:
   Rcu_batch _current;      ///< current batch
   Rcu_batch _completed;    ///< last completed batch
   bool _next_pending;      ///< next batch already pending?
+  Rcu_batch _expedited;    ///< last batch forced by an expedited grace period
+  unsigned long _expedite_cnt; ///< number of expedited grace periods
   Spin_lock<> _lock;
   Cpu_mask _cpus;
 
@@ -138,6 +151,15 @@ class Rcu
 public:
   /// The lock to prevent a quiescent state.
   typedef Cpu_lock Lock;
+
+  enum
+  {
+    /// Callbacks run per CPU and quiescent point.
+    Batch_limit = 64,
+    /// Queue length on one CPU that triggers an expedited grace period.
+    Expedite_len = 1000,
+  };
+
   static Rcu_glbl *rcu() { return &_rcu; }
 private:
   static Rcu_glbl _rcu;
@@ -191,7 +213,9 @@ IMPLEMENTATION:
 #include "cpu.h"
 #include "cpu_lock.h"
 #include "globals.h"
+#include "ipi.h"
 #include "kdb_ke.h"
+#include "kmem_alloc.h"
 #include "lock_guard.h"
 #include "mem.h"
 #include "static_init.h"
@@ -223,7 +247,9 @@ DEFINE_PER_CPU static Per_cpu<Rcu_timeout> _rcu_timeout;
 PUBLIC
 Rcu_glbl::Rcu_glbl()
 : _current(-300),
-  _completed(-300)
+  _completed(-300),
+  _expedited(-300),
+  _expedite_cnt(0)
 {}
 
 PUBLIC
@@ -254,24 +280,21 @@ PRIVATE inline NOEXPORT NEEDS["cpu_lock.h", "lock_guard.h"]
 bool
 Rcu_data::do_batch()
 {
-  int count = 0;
+  // Bound the work per quiescent point, unless callbacks pile up anyway.
+  // The rest stays on the done list and keeps the CPU pending.
+  long limit = _len > Rcu::Expedite_len ? _len : (long)Rcu::Batch_limit;
+  long count = 0;
   bool need_resched = false;
-  for (Rcu_list::Const_iterator l = _d.begin(); l != _d.end();)
+  while (count < limit && !_d.empty())
     {
-      Rcu_item *i = *l;
-      ++l;
-
+      // the callback usually frees the item, so dequeue it before
+      Rcu_item *i = _d.pop_front();
       need_resched |= i->_call_back(i);
       ++count;
     }
 
   // XXX: I do not know why this and the former stuff is w/o cpu lock
   //      but the couting needs it?
-  _d.clear();
-
-  // XXX: we use clear, we seemingly worked through the whole list
-  //_d.head(l);
-
     {
       auto guard = lock_guard(cpu_lock);
       _len -= count;
@@ -350,6 +373,35 @@ Rcu_glbl::cpu_quiet(Cpu_number cpu)
     }
 }
 
+/**
+ * Force the running grace period to end soon.
+ *
+ * Sends a request IPI to all CPUs that still have to pass a quiescent
+ * state. The IPI handler is a quiescent state itself and, with the batch
+ * marked as expedited, reports it at once instead of waiting for the next
+ * timer tick.
+ */
+PUBLIC
+void
+Rcu_glbl::expedite()
+{
+  Cpu_mask cpus;
+    {
+      auto guard = lock_guard(_lock);
+      if (_completed == _current || _expedited == _current)
+        return;
+
+      _expedited = _current;
+      ++_expedite_cnt;
+      cpus = _cpus;
+    }
+
+  Cpu_number self = current_cpu();
+  for (Cpu_number n = Cpu_number::first(); n < Config::max_num_cpus(); ++n)
+    if (n != self && cpus.get(n))
+      Ipi::send(Ipi::Request, self, n);
+}
+
 PRIVATE
 void
 Rcu_data::check_quiescent_state(Rcu_glbl *rgp)
@@ -360,7 +412,12 @@ Rcu_data::check_quiescent_state(Rcu_glbl *rgp)
       _pending = 1;
       _q_passed = 0;
       _q_batch = rgp->_current;
-      return;
+
+      // an expedited grace period accepts the quiescent state we are in
+      if (EXPECT_TRUE(rgp->_expedited != _q_batch))
+        return;
+
+      _q_passed = 1;
     }
 
   // Is the grace period already completed for this cpu?
@@ -423,6 +480,7 @@ Rcu_data::~Rcu_data()
     }
 
   current_rdp->move_batch(_c);
+  current_rdp->move_batch(_r);
   current_rdp->move_batch(_n);
   current_rdp->move_batch(_d);
 }
@@ -437,29 +495,57 @@ Rcu_data::process_callbacks(Rcu_glbl *rgp)
       l->event = Rcu::Rcu_process);
 
   if (!_c.empty() && rgp->_completed >= _batch)
-    _d.append(_c);
-
-  if (!_n.empty() && _c.empty())
     {
-	{
-	  auto guard = lock_guard(cpu_lock);
-	  _c = cxx::move(_n);
-	}
+      _d.append(_c);
 
-      // start the next batch of callbacks
+      // the ready list waits for the next batch already
+      _batch = _r_batch;
+      _c.append(_r);
+    }
 
-      _batch = rgp->_current + 1;
-      Mem::mp_rmb();
+  if (!_n.empty())
+    {
+      // New callbacks join the current or the ready list if that waits
+      // for the batch after the running one, so that a new grace period
+      // can start while the previous callbacks still wait.
+      Rcu_batch b = rgp->_current + 1;
+      Rcu_list *l = 0;
+      if (_c.empty())
+        {
+          _batch = b;
+          l = &_c;
+        }
+      else if (_batch == b)
+        l = &_c;
+      else if (_r.empty() || _r_batch == b)
+        {
+          _r_batch = b;
+          l = &_r;
+        }
 
-      if (!rgp->_next_pending)
-	{
-	  // start the batch and schedule start if it's a new batch
-	  auto guard = lock_guard(rgp->_lock);
-	  rgp->_next_pending = 1;
-	  rgp->start_batch();
+      if (l)
+        {
+	    {
+	      auto guard = lock_guard(cpu_lock);
+	      l->append(_n);
+	    }
+
+	  // start the next batch of callbacks
+	  Mem::mp_rmb();
+
+	  if (!rgp->_next_pending)
+	    {
+	      // start the batch and schedule start if it's a new batch
+	      auto guard = lock_guard(rgp->_lock);
+	      rgp->_next_pending = 1;
+	      rgp->start_batch();
+	    }
 	}
     }
 
+  if (EXPECT_FALSE(_len > Rcu::Expedite_len))
+    rgp->expedite();
+
   check_quiescent_state(rgp);
   if (!_d.empty())
     return do_batch();
@@ -476,8 +562,8 @@ Rcu_data::pending(Rcu_glbl *rgp) const
   if (!_c.empty() && rgp->_completed >= _batch)
     return 1;
 
-  // The CPU has no pending RCU callbacks, however there are new callbacks
-  if (_c.empty() && !_n.empty())
+  // There are new callbacks and a free list to put them on
+  if (!_n.empty() && (_c.empty() || _r.empty()))
     return 1;
 
   // The CPU has callbacks to be invoked finally
@@ -518,6 +604,21 @@ Rcu::idle(Cpu_number cpu)
   return d->_c.empty() && !d->pending(&_rcu);
 }
 
+/**
+ * Memory reaper: a desperate allocator shall not wait for the next
+ * timer ticks to get RCU-freed memory back.
+ */
+PUBLIC static
+size_t
+Rcu::reap(bool desperate)
+{
+  if (desperate)
+    rcu()->expedite();
+  return 0;
+}
+
+static Kmem_alloc_reaper rcu_reaper(Rcu::reap);
+
 PUBLIC static inline
 void
 Rcu::inc_q_cnt(Cpu_number cpu)
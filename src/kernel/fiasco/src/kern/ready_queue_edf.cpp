@@ -0,0 +1,123 @@
+INTERFACE [sched_fp_edf]:
+
+#include <cxx/dlist>
+#include "member_offs.h"
+#include "types.h"
+#include "globals.h"
+
+struct L4_sched_param_edf : public L4_sched_param
+{
+  enum : Smword { Class = -3 };
+  Mword budget;  ///< execution time per period, in microseconds
+  Mword period;  ///< period and relative deadline, in microseconds
+};
+
+/**
+ * Ready queue of constant bandwidth servers, ordered by absolute deadline.
+ *
+ * Servers that used up their budget before their deadline are throttled
+ * until then and wait in a second list ordered by their release time.
+ * Both lists are short in practice, so they are kept sorted on insertion.
+ */
+template<typename E>
+class Ready_queue_edf
+{
+  friend class Jdb_thread_list;
+  friend class Jdb_cpu;
+  template<typename T>
+  friend struct Jdb_thread_list_policy;
+
+private:
+  typedef typename E::Edf_list List;
+
+  List _ready;
+  List _throttled;
+  unsigned _nr_ready;
+
+public:
+  void enqueue(E *, bool throttle);
+  void dequeue(E *);
+  E *next_to_run() const { return _ready.front(); }
+  E *first_throttled() const { return _throttled.front(); }
+
+  /// Number of ready servers, not counting throttled ones.
+  unsigned nr_ready() const { return _nr_ready; }
+};
+
+
+// ---------------------------------------------------------------------------
+IMPLEMENTATION [sched_fp_edf]:
+
+#include <cassert>
+#include "cpu_lock.h"
+#include "kdb_ke.h"
+#include "std_macros.h"
+
+/**
+ * Insert e into l behind all elements with a key not greater than its own.
+ */
+PRIVATE static inline
+template<typename E>
+void
+Ready_queue_edf<E>::insert_sorted(List &l, E *e, Unsigned64 E::*key)
+{
+  for (typename List::Iterator i = l.begin(); i != l.end(); ++i)
+    if (e->*key < (*i)->*key)
+      {
+        if (*i == l.front())
+          l.push_front(e);
+        else
+          List::insert_before(e, i);
+        return;
+      }
+
+  l.push_back(e);
+}
+
+/**
+ * Enqueue server in the ready list, or in the throttled list if throttle
+ * is set.
+ */
+IMPLEMENT
+template<typename E>
+void
+Ready_queue_edf<E>::enqueue(E *i, bool throttle)
+{
+  assert_kdb(cpu_lock.test());
+
+  // Don't enqueue threads which are already enqueued
+  if (EXPECT_FALSE (i->in_ready_list()))
+    return;
+
+  i->_throttled = throttle;
+  if (throttle)
+    insert_sorted(_throttled, i, &E::_release);
+  else
+    {
+      insert_sorted(_ready, i, &E::_dl);
+      ++_nr_ready;
+    }
+}
+
+/**
+ * Remove server from the ready or throttled list.
+ */
+IMPLEMENT inline NEEDS ["cpu_lock.h", "kdb_ke.h", "std_macros.h"]
+template<typename E>
+void
+Ready_queue_edf<E>::dequeue(E *i)
+{
+  assert_kdb (cpu_lock.test());
+
+  // Don't dequeue threads which aren't enqueued
+  if (EXPECT_FALSE (!i->in_ready_list()))
+    return;
+
+  if (i->_throttled)
+    _throttled.remove(i);
+  else
+    {
+      _ready.remove(i);
+      --_nr_ready;
+    }
+}
@@ -1,4 +1,4 @@
-INTERFACE [sched_fixed_prio || sched_fp_wfq]:
+INTERFACE [sched_fixed_prio || sched_fp_wfq || sched_fp_edf]:
 
 #include "config.h"
 #include <cxx/dlist>
@@ -23,21 +23,42 @@ class Ready_queue_fp
 
 private:
   typedef typename E::Fp_list List;
+
+  enum
+  {
+    Num_prios = 256,
+    Map_words = Num_prios / MWORD_BITS,
+  };
+
   unsigned prio_highest;
-  List prio_next[256];
+  /// bitmap of non-empty priority levels
+  Mword _prio_map[Map_words];
+  /// bitmap of non-zero words in _prio_map
+  Mword _prio_map_words;
+  unsigned _nr_ready;
+  E *_idle;
+  List prio_next[Num_prios];
+
+  static_assert(Map_words <= MWORD_BITS, "priority bitmap summary too small");
 
 public:
   void set_idle(E *sc)
-  { sc->_prio = Config::Kernel_prio; }
+  {
+    sc->_prio = Config::Kernel_prio;
+    _idle = sc;
+  }
 
   void enqueue(E *, bool);
   void dequeue(E *);
   E *next_to_run() const;
+
+  /// Number of ready scheduling contexts, not counting the idle thread.
+  unsigned nr_ready() const { return _nr_ready; }
 };
 
 
 // ---------------------------------------------------------------------------
-IMPLEMENTATION [sched_fixed_prio || sched_fp_wfq]:
+IMPLEMENTATION [sched_fixed_prio || sched_fp_wfq || sched_fp_edf]:
 
 #include <cassert>
 #include "cpu_lock.h"
@@ -52,6 +73,41 @@ E *
 Ready_queue_fp<E>::next_to_run() const
 { return prio_next[prio_highest].front(); }
 
+PRIVATE inline
+template<typename E>
+void
+Ready_queue_fp<E>::prio_map_set(unsigned prio)
+{
+  _prio_map[prio / MWORD_BITS] |= 1UL << (prio % MWORD_BITS);
+  _prio_map_words |= 1UL << (prio / MWORD_BITS);
+}
+
+PRIVATE inline
+template<typename E>
+void
+Ready_queue_fp<E>::prio_map_clear(unsigned prio)
+{
+  Mword &w = _prio_map[prio / MWORD_BITS];
+  w &= ~(1UL << (prio % MWORD_BITS));
+  if (!w)
+    _prio_map_words &= ~(1UL << (prio / MWORD_BITS));
+}
+
+/**
+ * Find the highest non-empty priority level, 0 if all levels are empty.
+ */
+PRIVATE inline
+template<typename E>
+unsigned
+Ready_queue_fp<E>::find_prio_highest() const
+{
+  if (EXPECT_FALSE(!_prio_map_words))
+    return 0;
+
+  unsigned w = MWORD_BITS - 1 - __builtin_clzl(_prio_map_words);
+  return w * MWORD_BITS + MWORD_BITS - 1 - __builtin_clzl(_prio_map[w]);
+}
+
 /**
  * Enqueue context in ready-list.
  */
@@ -71,6 +127,12 @@ Ready_queue_fp<E>::enqueue(E *i, bool is_current_sched)
   if (prio > prio_highest)
     prio_highest = prio;
 
+  if (prio_next[prio].empty())
+    prio_map_set(prio);
+
+  if (i != _idle)
+    ++_nr_ready;
+
   prio_next[prio].push(i, is_current_sched ? List::Front : List::Back);
 }
 
@@ -92,8 +154,15 @@ Ready_queue_fp<E>::dequeue(E *i)
 
   prio_next[prio].remove(i);
 
-  while (prio_next[prio_highest].empty() && prio_highest)
-    prio_highest--;
+  if (i != _idle)
+    --_nr_ready;
+
+  if (!prio_next[prio].empty())
+    return;
+
+  prio_map_clear(prio);
+  if (prio == prio_highest)
+    prio_highest = find_prio_highest();
 }
 
 
@@ -34,6 +34,9 @@ public:
   void dequeue(E *);
   E *next_to_run() const;
 
+  /// Number of ready scheduling contexts, not counting the idle thread.
+  unsigned nr_ready() const { return _cnt; }
+
 private:
   void swap(unsigned a, unsigned b);
   void heap_up(unsigned a);
@@ -0,0 +1,436 @@
+INTERFACE [sched_fp_edf]:
+
+#include <cxx/dlist>
+#include "member_offs.h"
+#include "types.h"
+#include "globals.h"
+#include "ready_queue_fp.h"
+#include "ready_queue_edf.h"
+#include "timeout.h"
+
+/**
+ * Fixed priority scheduling context with an additional class of
+ * constant bandwidth servers (CBS).
+ *
+ * A server gets a budget of execution time per period and is scheduled
+ * earliest deadline first, ahead of all fixed priority contexts. The
+ * budget is enforced with the timeslice timeout: a server that uses up
+ * its budget gets its deadline postponed by one period and is throttled
+ * until its old deadline. So a server never gets more than its share of
+ * the CPU, and servers that stay within their budget meet their deadlines
+ * as long as the shares on a CPU add up to at most one.
+ */
+class Sched_context
+{
+  MEMBER_OFFSET();
+  friend class Jdb_list_timeouts;
+  friend class Jdb_thread_list;
+  friend class Jdb_cpu;
+  friend class Ready_queue_fp<Sched_context>;
+  friend class Ready_queue_edf<Sched_context>;
+
+  template<typename T>
+  friend struct Jdb_thread_list_policy;
+
+  union Sp
+  {
+    L4_sched_param p;
+    L4_sched_param_legacy legacy_fixed_prio;
+    L4_sched_param_fixed_prio fixed_prio;
+    L4_sched_param_edf edf;
+  };
+
+  struct Ready_list_item_concept
+  {
+    typedef Sched_context Item;
+    static Sched_context *&next(Sched_context *e) { return e->_ready_next; }
+    static Sched_context *&prev(Sched_context *e) { return e->_ready_prev; }
+    static Sched_context const *next(Sched_context const *e)
+    { return e->_ready_next; }
+    static Sched_context const *prev(Sched_context const *e)
+    { return e->_ready_prev; }
+  };
+
+public:
+  enum Type { Fixed_prio, Edf };
+
+  enum
+  {
+    /// priority reported for servers, e.g. for ordering IPC senders
+    Edf_prio       = 255,
+    /// longest supported period, in microseconds
+    Edf_max_period = 1UL << 31,
+  };
+
+  typedef cxx::Sd_list<Sched_context, Ready_list_item_concept> Fp_list;
+  typedef Fp_list Edf_list;
+
+  /// Moves throttled servers back to the ready list at their release time.
+  class Release_timeout : public Timeout
+  {
+  private:
+    bool expired();
+  };
+
+  struct Ready_queue_base
+  {
+  public:
+    Ready_queue_fp<Sched_context> fp_rq;
+    Ready_queue_edf<Sched_context> edf_rq;
+    Sched_context *current_sched() const { return _current_sched; }
+    void activate(Sched_context *s);
+
+    void enqueue(Sched_context *sc, bool is_current);
+    void dequeue(Sched_context *);
+    void requeue(Sched_context *sc);
+
+    void set_idle(Sched_context *sc) { fp_rq.set_idle(sc); }
+
+    Sched_context *next_to_run() const;
+    void deblock_refill(Sched_context *sc);
+    bool release_expired();
+
+    unsigned nr_ready() const
+    { return fp_rq.nr_ready() + edf_rq.nr_ready(); }
+
+  private:
+    friend class Jdb_thread_list;
+    void arm_release(Unsigned64 release);
+
+    Sched_context *_current_sched;
+    Release_timeout _release_to;
+  };
+
+  Context *context() const { return context_of(this); }
+
+private:
+  Type _t;
+  unsigned short _prio;
+  Unsigned64 _quantum;
+  Unsigned64 _left;
+  Sched_context *_ready_next, *_ready_prev;
+
+  // constant bandwidth server state, all times in microseconds
+  Unsigned64 _budget;
+  Unsigned64 _period;
+  Unsigned64 _dl;       ///< absolute deadline
+  Unsigned64 _release;  ///< end of the throttling after a budget overrun
+  Mword _throttle_cnt;
+  bool _throttled;
+};
+
+
+IMPLEMENTATION [sched_fp_edf]:
+
+#include <cassert>
+#include "cpu_lock.h"
+#include "kdb_ke.h"
+#include "std_macros.h"
+#include "config.h"
+#include "timer.h"
+
+/**
+ * Constructor
+ */
+PUBLIC
+Sched_context::Sched_context()
+: _t(Fixed_prio),
+  _prio(Config::Default_prio),
+  _quantum(Config::Default_time_slice),
+  _left(Config::Default_time_slice),
+  _ready_next(0),
+  _budget(0), _period(0), _dl(0), _release(0), _throttle_cnt(0),
+  _throttled(false)
+{}
+
+/**
+ * Check if Context is in ready-list, throttled servers included.
+ * @return 1 if thread is in ready-list, 0 otherwise
+ */
+PUBLIC inline
+Mword
+Sched_context::in_ready_list() const
+{
+  return Fp_list::in_list(this);
+}
+
+PUBLIC inline
+unsigned short
+Sched_context::prio() const
+{ return _prio; }
+
+PUBLIC inline
+Sched_context::Type
+Sched_context::type() const
+{ return _t; }
+
+PUBLIC
+int
+Sched_context::set(L4_sched_param const *_p)
+{
+  Sp const *p = reinterpret_cast<Sp const *>(_p);
+  if (p->p.sched_class >= 0)
+    {
+      // legacy fixed prio
+      _t = Fixed_prio;
+      _prio = p->legacy_fixed_prio.prio;
+      if (p->legacy_fixed_prio.prio > 255)
+        _prio = 255;
+
+      _quantum = p->legacy_fixed_prio.quantum;
+      if (p->legacy_fixed_prio.quantum == 0)
+        _quantum = Config::Default_time_slice;
+      return 0;
+    }
+
+  switch (p->p.sched_class)
+    {
+    case L4_sched_param_fixed_prio::Class:
+      _t = Fixed_prio;
+      _prio = p->fixed_prio.prio;
+      if (p->fixed_prio.prio > 255)
+        _prio = 255;
+
+      _quantum = p->fixed_prio.quantum;
+      if (p->fixed_prio.quantum == 0)
+        _quantum = Config::Default_time_slice;
+      break;
+
+    case L4_sched_param_edf::Class:
+      if (p->p.length < sizeof(L4_sched_param_edf)
+          || p->edf.budget == 0 || p->edf.budget > p->edf.period
+          || p->edf.period > Edf_max_period)
+        return -L4_err::EInval;
+
+      _t = Edf;
+      _prio = Edf_prio;
+      _budget = p->edf.budget;
+      _period = p->edf.period;
+      // replenish() starts the first period now
+      _dl = Timer::system_clock();
+      _release = 0;
+      _throttle_cnt = 0;
+      _throttled = false;
+      break;
+
+    default:
+      return -L4_err::ERange;
+    };
+  return 0;
+}
+
+/**
+ * Return remaining time quantum, or budget, of Sched_context
+ */
+PUBLIC inline
+Unsigned64
+Sched_context::left() const
+{
+  return _left;
+}
+
+/**
+ * Set remaining time quantum of Sched_context
+ */
+PUBLIC inline
+void
+Sched_context::set_left(Unsigned64 left)
+{
+  _left = left;
+}
+
+/**
+ * Refill the quantum. A server used up its budget, so it gets a fresh
+ * budget for the next period and may not run before the end of the
+ * current one.
+ */
+PUBLIC inline
+void
+Sched_context::replenish()
+{
+  if (_t == Fixed_prio)
+    {
+      _left = _quantum;
+      return;
+    }
+
+  _left = _budget;
+  _release = _dl;
+  _dl += _period;
+}
+
+PUBLIC inline
+bool
+Sched_context::dominates(Sched_context *sc)
+{
+  if (_t == Edf)
+    return !_throttled
+           && (sc->_t != Edf || sc->_throttled || _dl < sc->_dl);
+
+  if (sc->_t == Edf)
+    return sc->_throttled;
+
+  return prio() > sc->prio();
+}
+
+IMPLEMENT inline
+Sched_context *
+Sched_context::Ready_queue_base::next_to_run() const
+{
+  if (Sched_context *s = edf_rq.next_to_run())
+    return s;
+
+  return fp_rq.next_to_run();
+}
+
+/**
+ * Make s the current Sched_context. A server losing the CPU may have
+ * used up its budget meanwhile, which set_current_sched() handles by
+ * replenish() only, so it gets sorted in again.
+ */
+IMPLEMENT inline
+void
+Sched_context::Ready_queue_base::activate(Sched_context *s)
+{
+  Sched_context *prev = _current_sched;
+  _current_sched = s;
+  if (prev && prev != s && prev->_t == Edf && prev->in_ready_list())
+    requeue(prev);
+}
+
+IMPLEMENT
+void
+Sched_context::Ready_queue_base::arm_release(Unsigned64 release)
+{
+  if (_release_to.is_set())
+    _release_to.reset();
+
+  _release_to.set(release, current_cpu());
+}
+
+/**
+ * Enqueue context in ready-list.
+ */
+IMPLEMENT
+void
+Sched_context::Ready_queue_base::enqueue(Sched_context *sc, bool is_current)
+{
+  if (sc->_t == Fixed_prio)
+    {
+      fp_rq.enqueue(sc, is_current);
+      return;
+    }
+
+  if (EXPECT_FALSE(sc->in_ready_list()))
+    return;
+
+  // The release timeout can only be programmed locally, a server queued
+  // on a remote (offline) CPU is never throttled.
+  bool throttle = false;
+  if (static_cast<Ready_queue *>(this) == &rq.current())
+    {
+      Unsigned64 now = Timer::system_clock();
+      if (sc->_release > now)
+        throttle = true;
+      else if (sc->_dl <= now)
+        {
+          // start a new period instead of catching up on missed ones
+          sc->_dl = now + sc->_period;
+          sc->_left = sc->_budget;
+        }
+    }
+
+  edf_rq.enqueue(sc, throttle);
+  if (throttle)
+    {
+      ++sc->_throttle_cnt;
+      if (edf_rq.first_throttled() == sc)
+        arm_release(sc->_release);
+    }
+}
+
+/**
+ * Remove context from ready-list.
+ */
+IMPLEMENT inline NEEDS ["cpu_lock.h", "kdb_ke.h", "std_macros.h"]
+void
+Sched_context::Ready_queue_base::dequeue(Sched_context *sc)
+{
+  // a pending release timeout for sc just finds nothing to release
+  if (sc->_t == Fixed_prio)
+    fp_rq.dequeue(sc);
+  else
+    edf_rq.dequeue(sc);
+}
+
+IMPLEMENT
+void
+Sched_context::Ready_queue_base::requeue(Sched_context *sc)
+{
+  if (sc->_t == Fixed_prio)
+    {
+      fp_rq.requeue(sc);
+      return;
+    }
+
+  // re-sort by the new deadline, or throttle
+  edf_rq.dequeue(sc);
+  enqueue(sc, false);
+}
+
+/**
+ * CBS wakeup rule: keep the deadline only if the remaining budget fits
+ * into the time left until it, at the reserved bandwidth.
+ */
+IMPLEMENT inline NEEDS["timer.h"]
+void
+Sched_context::Ready_queue_base::deblock_refill(Sched_context *sc)
+{
+  if (sc->_t == Fixed_prio)
+    return;
+
+  Unsigned64 now = Timer::system_clock();
+  sc->_throttled = sc->_release > now;
+  if (sc->_throttled)
+    return;
+
+  if (sc->_dl <= now
+      || sc->_left * sc->_period >= (sc->_dl - now) * sc->_budget)
+    {
+      sc->_dl = now + sc->_period;
+      sc->_left = sc->_budget;
+    }
+}
+
+/**
+ * Move all servers with a release time in the past back to the ready
+ * list.
+ * @return true if a server has been released
+ */
+IMPLEMENT
+bool
+Sched_context::Ready_queue_base::release_expired()
+{
+  Unsigned64 now = Timer::system_clock();
+  bool released = false;
+
+  while (Sched_context *sc = edf_rq.first_throttled())
+    {
+      if (sc->_release > now)
+        {
+          arm_release(sc->_release);
+          break;
+        }
+
+      edf_rq.dequeue(sc);
+      edf_rq.enqueue(sc, false);
+      released = true;
+    }
+
+  return released;
+}
+
+IMPLEMENT
+bool
+Sched_context::Release_timeout::expired()
+{ return rq.current().release_expired(); }
@@ -96,6 +96,9 @@ public:
     Sched_context *next_to_run() const;
     void deblock_refill(Sched_context *sc);
 
+    unsigned nr_ready() const
+    { return fp_rq.nr_ready() + wfq_rq.nr_ready(); }
+
   private:
     friend class Jdb_thread_list;
     Sched_context *_current_sched;
@@ -7,6 +7,16 @@ public:
   class Ready_queue : public Ready_queue_base
   {
   public:
+    enum
+    {
+      /// fixed-point shift of load(), 1 << Load_shift is one ready thread
+      Load_shift  = 11,
+      /// sample the number of ready threads every Load_period timer ticks
+      Load_period = 100,
+      /// decay per sample, exp(-1/10) gives a 1s time constant at 1ms ticks
+      Load_decay  = 1853,
+    };
+
     void set_current_sched(Sched_context *sched);
     void invalidate_sched() { activate(0); }
     bool deblock(Sched_context *sc, Sched_context *crs, bool lazy_q = false);
@@ -47,8 +57,17 @@ public:
       enqueue(to, false);
     }
 
+    void update_load();
+
+    /// Exponentially averaged number of ready threads, see Load_shift.
+    Mword load() const { return access_once(&_load); }
+
     Context *schedule_in_progress;
-  };
+
+  private:
+    Mword _load;
+    unsigned _load_ticks;
+  } __attribute__((aligned(Config::Cache_line_size)));
 
   static Per_cpu<Ready_queue> rq;
 };
@@ -97,17 +116,36 @@ Sched_context::Ready_queue::set_current_sched(Sched_context *sched)
 }
 
 
+/**
+ * Account one timer tick for the load average of this CPU.
+ */
+IMPLEMENT inline
+void
+Sched_context::Ready_queue::update_load()
+{
+  if (++_load_ticks < Load_period)
+    return;
+
+  _load_ticks = 0;
+  Unsigned64 l = (Unsigned64)_load * Load_decay
+    + ((Unsigned64)nr_ready() << Load_shift) * ((1 << Load_shift) - Load_decay);
+  write_now(&_load, Mword(l >> Load_shift));
+}
+
 /**
  * \param sc Sched_context that shall be deblocked
  * \param crs the Sched_context of the currently running context
  * \param lazy_q queue lazily if applicable
  */
-IMPLEMENT inline NEEDS["kdb_ke.h"]
+IMPLEMENT inline NEEDS["kdb_ke.h", "timer.h"]
 bool
 Sched_context::Ready_queue::deblock(Sched_context *sc, Sched_context *crs, bool lazy_q)
 {
   assert_kdb(cpu_lock.test());
 
+  // a second ready thread needs the tick for time slicing
+  Timer::tick_needed(current_cpu(), 0);
+
   Sched_context *cs = current_sched();
   bool res = true;
   if (sc == cs)
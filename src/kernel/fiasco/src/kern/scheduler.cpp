@@ -15,6 +15,7 @@ public:
     Info       = 0,
     Run_thread = 1,
     Idle_time  = 2,
+    Load_info  = 3,
   };
 
   static Scheduler scheduler;
@@ -138,6 +139,32 @@ Scheduler::sys_idle_time(L4_fpage::Rights,
   return commit_result(0, Utcb::Time_val::Words);
 }
 
+/**
+ * Report the number of ready threads and their exponentially averaged
+ * number (fixed point, see Sched_context::Ready_queue::Load_shift) for
+ * the first online CPU in the given set.
+ */
+PRIVATE
+L4_msg_tag
+Scheduler::sys_load_info(L4_fpage::Rights,
+                         Syscall_frame *f, Utcb *utcb)
+{
+  if (f->tag().words() < 3)
+    return commit_result(-L4_err::EInval);
+
+  L4_cpu_set cpus = access_once(reinterpret_cast<L4_cpu_set const *>(&utcb->values[1]));
+  Cpu_number const cpu = cpus.first(Cpu::online_mask(), Config::max_num_cpus());
+  if (EXPECT_FALSE(cpu == Config::max_num_cpus()))
+    return commit_result(-L4_err::EInval);
+
+  Sched_context::Ready_queue const &rq = Sched_context::rq.cpu(cpu);
+  utcb->values[0] = rq.nr_ready();
+  utcb->values[1] = rq.load();
+  utcb->values[2] = Sched_context::Ready_queue::Load_shift;
+
+  return commit_result(0, 3);
+}
+
 PRIVATE
 L4_msg_tag
 Scheduler::sys_info(L4_fpage::Rights, Syscall_frame *f,
@@ -241,6 +268,7 @@ Scheduler::kinvoke(L4_obj_ref ref, L4_fpage::Rights rights, Syscall_frame *f,
     case Info:       return sys_info(rights, f, iutcb, outcb);
     case Run_thread: return sys_run(rights, f, iutcb);
     case Idle_time:  return sys_idle_time(rights, f, outcb);
+    case Load_info:  return sys_load_info(rights, f, outcb);
     default:         return commit_result(-L4_err::ENosys);
     }
 }
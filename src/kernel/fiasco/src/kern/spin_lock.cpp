@@ -117,6 +117,7 @@ Spin_lock_coloc<T>::set_unused(T val)
 IMPLEMENTATION [mp]:
 
 #include <cassert>
+#include "lat_hist.h"
 #include "mem.h"
 
 PUBLIC template<typename Lock_t> inline
@@ -133,43 +134,54 @@ Spin_lock<Lock_t>::test() const
   return (!!cpu_lock.test()) | (_lock & Arch_lock);
 }
 
-PUBLIC template<typename Lock_t> inline NEEDS[<cassert>, Spin_lock::lock_arch, "mem.h"]
+PUBLIC template<typename Lock_t> inline NEEDS[<cassert>, Spin_lock::lock_arch,
+                                              "lat_hist.h", "mem.h"]
 void
 Spin_lock<Lock_t>::lock()
 {
   assert(!cpu_lock.test());
   cpu_lock.lock();
+  Lat_hist::Stamp t = Lat_hist::now();
   lock_arch();
+  Lat_hist::spin_acquired(this, t);
   Mem::mp_mb();
 }
 
-PUBLIC template<typename Lock_t> inline NEEDS[Spin_lock::unlock_arch, "mem.h"]
+PUBLIC template<typename Lock_t> inline NEEDS[Spin_lock::unlock_arch,
+                                              "lat_hist.h", "mem.h"]
 void
 Spin_lock<Lock_t>::clear()
 {
   Mem::mp_mb();
+  Lat_hist::spin_released(this);
   unlock_arch();
   Cpu_lock::clear();
 }
 
-PUBLIC template<typename Lock_t> inline NEEDS[Spin_lock::lock_arch, "mem.h"]
+PUBLIC template<typename Lock_t> inline NEEDS[Spin_lock::lock_arch,
+                                              "lat_hist.h", "mem.h"]
 typename Spin_lock<Lock_t>::Status
 Spin_lock<Lock_t>::test_and_set()
 {
   Status s = !!cpu_lock.test();
   cpu_lock.lock();
+  Lat_hist::Stamp t = Lat_hist::now();
   lock_arch();
+  Lat_hist::spin_acquired(this, t);
   Mem::mp_mb();
   return s;
 }
 
-PUBLIC template<typename Lock_t> inline
+PUBLIC template<typename Lock_t> inline NEEDS["lat_hist.h"]
 void
 Spin_lock<Lock_t>::set(Status s)
 {
   Mem::mp_mb();
   if (!(s & Arch_lock))
-    unlock_arch();
+    {
+      Lat_hist::spin_released(this);
+      unlock_arch();
+    }
 
   if (!(s & 1))
     cpu_lock.clear();
@@ -74,6 +74,16 @@ public:
 #define NO_INSTRUMENT 
 
 
+INTERFACE [lat_hist]:
+
+#include "lat_hist.h"
+
+EXTENSION class Switch_lock
+{
+private:
+  Lat_hist::Stamp _hold_start;
+};
+
 IMPLEMENTATION:
 
 #include <cassert>
@@ -84,6 +94,7 @@ IMPLEMENTATION:
 #include "lock_guard.h"
 #include "context.h"
 #include "globals.h"
+#include "lat_hist.h"
 #include "processor.h"
 
 
@@ -147,7 +158,7 @@ Switch_lock::test() const
 	    The result is #Invalid if the lock does not exist (see valid()).
  */
 
-inline NEEDS["atomic.h"]
+inline NEEDS["atomic.h", Switch_lock::hold_start]
 Switch_lock::Status NO_INSTRUMENT
 Switch_lock::try_lock()
 {
@@ -159,7 +170,10 @@ Switch_lock::try_lock()
   bool ret = set_lock_owner(current());
 
   if (ret)
-    current()->inc_lock_cnt();	// Do not lose this lock if current is deleted
+    {
+      hold_start();
+      current()->inc_lock_cnt();	// Do not lose this lock if current is deleted
+    }
 
   return ret ? Locked : Not_locked;
 }
@@ -188,7 +202,8 @@ Switch_lock::lock()
  *          #Invalid if the lock does not exist (see valid()).
  */
 PUBLIC
-inline NEEDS["cpu.h","context.h", "processor.h", Switch_lock::set_lock_owner]
+inline NEEDS["cpu.h","context.h", "processor.h", "lat_hist.h",
+             Switch_lock::set_lock_owner, Switch_lock::hold_start]
 Switch_lock::Status NO_INSTRUMENT
 Switch_lock::lock_dirty()
 {
@@ -201,6 +216,7 @@ Switch_lock::lock_dirty()
   if ((_lock_owner & ~1UL) == Address(current()))
     return Locked;
 
+  Lat_hist::Stamp t = Lat_hist::now();
   do
     {
       for (;;)
@@ -226,6 +242,8 @@ Switch_lock::lock_dirty()
         }
     }
   while (!set_lock_owner(current()));
+  Lat_hist::record(Lat_hist_lock_wait, t);
+  hold_start();
   Mem::mp_wmb();
   current()->inc_lock_cnt();   // Do not lose this lock if current is deleted
   return Not_locked;
@@ -257,6 +275,30 @@ Switch_lock::test_and_set_dirty()
   return lock_dirty();
 }
 
+IMPLEMENTATION [!lat_hist]:
+
+PRIVATE inline
+void NO_INSTRUMENT
+Switch_lock::hold_start()
+{}
+
+PRIVATE inline
+void NO_INSTRUMENT
+Switch_lock::hold_end()
+{}
+
+IMPLEMENTATION [lat_hist]:
+
+PRIVATE inline NEEDS["lat_hist.h"]
+void NO_INSTRUMENT
+Switch_lock::hold_start()
+{ _hold_start = Lat_hist::now(); }
+
+PRIVATE inline NEEDS["lat_hist.h"]
+void NO_INSTRUMENT
+Switch_lock::hold_end()
+{ Lat_hist::record(Lat_hist_lock_hold, _hold_start); }
+
 IMPLEMENTATION [!mp]:
 
 PRIVATE inline
@@ -333,13 +375,14 @@ IMPLEMENTATION:
  * @post switch_dirty() must be called in the same atomical section
  */
 PROTECTED
-inline NEEDS[Switch_lock::clear_lock_owner]
+inline NEEDS[Switch_lock::clear_lock_owner, Switch_lock::hold_end]
 Switch_lock::Lock_context NO_INSTRUMENT
 Switch_lock::clear_no_switch_dirty()
 {
   Mem::mp_wmb();
   Lock_context c;
   c.owner = lock_owner();
+  hold_end();
   clear_lock_owner();
   c.owner->dec_lock_cnt();
   return c;
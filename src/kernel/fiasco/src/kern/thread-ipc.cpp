@@ -50,8 +50,22 @@ protected:
     Thread::Check_sender result;
   };
 
+  /**
+   * Access pattern of the user page faults, reported to the pager as a
+   * hint for fault-around. run counts the faults in a row that were
+   * stride bytes apart.
+   */
+  struct Pf_pattern
+  {
+    Address last;
+    Mword stride;
+    Mword run;
+    Pf_pattern() : last(0), stride(0), run(0) {}
+  };
+
   Syscall_frame *_snd_regs;
   L4_fpage::Rights _ipc_send_rights;
+  Pf_pattern _pf_pattern;
 };
 
 class Buf_utcb_saver
@@ -73,7 +87,7 @@ public:
   Pf_msg_utcb_saver(Utcb const *u);
   void restore(Utcb *u);
 private:
-  Mword msg[2];
+  Mword msg[3];
 };
 
 
@@ -122,9 +136,11 @@ IMPLEMENTATION:
 #include "config.h"
 #include "cpu_lock.h"
 #include "ipc_timeout.h"
+#include "lat_hist.h"
 #include "lock_guard.h"
 #include "logdefs.h"
 #include "map_util.h"
+#include "mem.h"
 #include "processor.h"
 #include "timer.h"
 #include "kdb_ke.h"
@@ -190,6 +206,45 @@ Thread::snd_regs(Syscall_frame *r)
 { _snd_regs = r; }
 
 
+/**
+ * Update the page-fault access pattern with a fault at pfa.
+ * A fault one stride behind a page that is mapped continues the pattern
+ * too, as the pager may have mapped the pages in between already.
+ * @return the fault-around hint for the pager: the stride between the
+ *         last faults in bytes, signed and page aligned, or-ed with the
+ *         number of faults in a row with that stride; 0 if there is no
+ *         pattern
+ */
+PRIVATE inline
+Mword
+Thread::pf_hint(Address pfa)
+{
+  enum { Run_max = Config::PAGE_SIZE - 1 };
+
+  Pf_pattern &p = _pf_pattern;
+  Address page = pfa & ~(Config::PAGE_SIZE - 1);
+
+  // a repeated fault on the same page, e.g. a write after a read
+  if (page != p.last)
+    {
+      Mword stride = page - p.last;
+      if (stride == p.stride
+          || (p.run && mem_space()->v_lookup(Virt_addr(page - p.stride))))
+        {
+          if (p.run < Run_max)
+            ++p.run;
+        }
+      else
+        {
+          p.stride = stride;
+          p.run = 0;
+        }
+      p.last = page;
+    }
+
+  return p.run ? p.stride | p.run : 0;
+}
+
 /** Page fault handler.
     This handler suspends any ongoing IPC, then sets up page-fault IPC.
     Finally, the ongoing IPC's state (if any) is restored.
@@ -246,10 +301,12 @@ Thread::handle_page_fault_pager(Thread_ptr const &_pager,
 
   utcb->values[0] = PF::addr_to_msgword0(pfa, error_code);
   utcb->values[1] = pf_ip;
+  utcb->values[2] = protocol == L4_msg_tag::Label_page_fault
+                    ? pf_hint(pfa) : 0;
 
   L4_timeout_pair timeout(L4_timeout::Never, L4_timeout::Never);
 
-  L4_msg_tag tag(2, 0, 0, protocol);
+  L4_msg_tag tag(3, 0, 0, protocol);
 
   r.timeout(timeout);
   r.tag(tag);
@@ -412,6 +469,78 @@ Thread::get_next_sender(Sender *sender)
 }
 
 
+/**
+ * Fastpath for call and reply-and-wait carrying untyped words only.
+ *
+ * Applies if the partner already waits for us on this CPU, no receive
+ * timeout must be armed, no items or FPU state are transferred and
+ * neither thread has DRQs pending or runs in vCPU mode. The words are
+ * copied UTCB to UTCB and we switch to the partner just as do_ipc()
+ * would.
+ * @pre cpu_lock must be held, prepare_receive() done
+ * @return false if nothing was done and the slow path must be taken
+ */
+PRIVATE inline NEEDS["logdefs.h", "mem.h", Thread::goto_sleep,
+                     Thread::finish_ipc]
+bool
+Thread::ipc_fastpath(L4_msg_tag const &tag, Thread *rcv, Sender *sender,
+                     L4_timeout rcv_t, Syscall_frame *regs,
+                     L4_fpage::Rights rights)
+{
+  Mword const no_fast = Thread_drq_ready | Thread_vcpu_enabled;
+
+  if (EXPECT_FALSE(tag.items() || tag.transfer_fpu() || !tag.do_switch()
+                   || !rcv_t.is_never()
+                   || rcv == this || rcv->home_cpu() != current_cpu()
+                   || (state() & no_fast)
+                   || (rcv->state() & (Thread_full_ipc_mask | no_fast))
+                      != Thread_receive_wait
+                   || _utcb_handler || rcv->_utcb_handler
+                   || drq_pending() || rcv->drq_pending()
+                   || !sender_list()->empty()
+                   || rcv->is_invalid()
+                   || rcv->sender_ok(this) != Receiver::Rs_ipc_receive))
+    {
+      CNT_SHORTCUT_FAILED;
+      return false;
+    }
+
+  CNT_SHORTCUT_SUCCESS;
+
+  rcv->reset_timeout();
+  rcv->state_change_dirty(~(Thread_ipc_mask | Thread_ready), Thread_ipc_transfer);
+
+  Mword s = tag.words();
+  Mword r = Utcb::Max_words;
+  Mem::memcpy_mwords(rcv->utcb().access()->values, utcb().access()->values,
+                     r < s ? r : s);
+
+  Syscall_frame *dst_regs = rcv->rcv_regs();
+  L4_msg_tag rcv_tag = tag;
+  rcv_tag.set_error(false);
+  dst_regs->tag(rcv_tag);
+  dst_regs->from(regs->from_spec());
+
+  // setup the reply capability in case of a call
+  if (partner() == rcv)
+    rcv->set_caller(this, rights);
+
+  state_add_dirty(Thread_receive_wait);
+  rcv->state_change_dirty(~Thread_ipc_transfer, Thread_ready);
+
+  // same switch policy as do_ipc(), there is no queued sender to take
+  if (sender || Sched_context::rq.current().current_sched() != sched())
+    schedule_if(switch_exec_locked(rcv, Not_Helping) != Switch::Ok);
+  else
+    deblock_and_schedule(rcv);
+
+  if ((state() & Thread_full_ipc_mask) == Thread_receive_wait)
+    goto_sleep(rcv_t, sender, utcb().access(true));
+
+  finish_ipc(regs);
+  return true;
+}
+
 /**
  * Send an IPC message.
  *        Block until we can send the message or the timeout hits.
@@ -431,11 +560,17 @@ Thread::do_ipc(L4_msg_tag const &tag, bool have_send, Thread *partner,
   assert_kdb (cpu_lock.test());
   assert_kdb (this == current());
 
+  Lat_hist::Scope ipc_lat(Lat_hist_ipc_call, have_send && have_receive);
   bool do_switch = false;
 
   assert_kdb (!(state() & Thread_ipc_mask));
 
   prepare_receive(sender, have_receive ? regs : 0);
+
+  if (have_send && have_receive
+      && ipc_fastpath(tag, partner, sender, t.rcv, regs, rights))
+    return;
+
   bool activate_partner = false;
   Cpu_number current_cpu = ::current_cpu();
 
@@ -559,6 +694,18 @@ Thread::do_ipc(L4_msg_tag const &tag, bool have_send, Thread *partner,
 	goto_sleep(t.rcv, sender, utcb().access(true));
     }
 
+  finish_ipc(regs);
+}
+
+/**
+ * Wait for a pending transfer to us and commit timeout or cancel errors
+ * of an unfinished receive.
+ * @pre cpu_lock must be held
+ */
+PRIVATE inline
+void
+Thread::finish_ipc(Syscall_frame *regs)
+{
   Mword state = this->state();
 
   if (EXPECT_TRUE (!(state & Thread_full_ipc_mask)))
@@ -635,6 +782,7 @@ Pf_msg_utcb_saver::Pf_msg_utcb_saver(Utcb const *u) : Buf_utcb_saver(u)
 {
   msg[0] = u->values[0];
   msg[1] = u->values[1];
+  msg[2] = u->values[2];
 }
 
 IMPLEMENT inline
@@ -644,6 +792,7 @@ Pf_msg_utcb_saver::restore(Utcb *u)
   Buf_utcb_saver::restore(u);
   u->values[0] = msg[0];
   u->values[1] = msg[1];
+  u->values[2] = msg[2];
 }
 
 
@@ -874,6 +1023,12 @@ Thread::transfer_msg_items(L4_msg_tag const &tag, Thread* snd, Utcb *snd_utcb,
   // snd->prepare_long_ipc(rcv);
   Reap_list rl;
 
+  // We take the existence_lock for syncronizing maps...
+  // This is kind of coarse grained, so take it once for all items of
+  // the message instead of once per item
+  auto sp_lock = lock_guard_dont_lock(rcv_t->existence_lock);
+  bool sp_locked = false;
+
   for (;items > 0 && snd_item.more();)
     {
       if (EXPECT_FALSE(!snd_item.next()))
@@ -942,13 +1097,14 @@ Thread::transfer_msg_items(L4_msg_tag const &tag, Thread* snd, Utcb *snd_utcb,
 	      L4_error err;
 
 		{
-		  // We take the existence_lock for syncronizing maps...
-		  // This is kind of coarse grained
-		  auto sp_lock = lock_guard_dont_lock(rcv_t->existence_lock);
-		  if (!sp_lock.check_and_lock(&rcv_t->existence_lock))
+		  if (!sp_locked)
 		    {
-		      snd->set_ipc_error(L4_error::Overflow, rcv);
-		      return false;
+		      if (!sp_lock.check_and_lock(&rcv_t->existence_lock))
+			{
+			  snd->set_ipc_error(L4_error::Overflow, rcv);
+			  return false;
+			}
+		      sp_locked = true;
 		    }
 
 		  auto c_lock = lock_guard<Lock_guard_inverse_policy>(cpu_lock);
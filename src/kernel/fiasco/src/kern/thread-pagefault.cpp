@@ -6,6 +6,7 @@ IMPLEMENTATION:
 #include "cpu.h"
 #include "kdb_ke.h"
 #include "kmem.h"
+#include "lat_hist.h"
 #include "logdefs.h"
 #include "processor.h"
 #include "std_macros.h"
@@ -57,6 +58,7 @@ int Thread::handle_page_fault(Address pfa, Mword error_code, Mword pc,
 
 
   CNT_PAGE_FAULT;
+  Lat_hist::Scope pf_lat(Lat_hist_page_fault);
 
   // TODO: put this into a debug_page_fault_handler
   if (EXPECT_FALSE(log_page_fault()))
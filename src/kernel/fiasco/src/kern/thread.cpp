@@ -1,6 +1,7 @@
 INTERFACE:
 
 #include "l4_types.h"
+#include "cap_cache.h"
 #include "config.h"
 #include "continuation.h"
 #include "helping_lock.h"
@@ -55,6 +56,8 @@ public:
     Op_register_del_irq = 5,
     Op_modify_senders = 6,
     Op_vcpu_control= 7,
+    Op_batch_control = 8,
+    Op_batch_submit = 9,
     Op_gdt_x86 = 0x10,
     Op_set_tpidruro_arm = 0x10,
     Op_set_segment_base_amd64 = 0x12,
@@ -149,6 +152,9 @@ protected:
   Thread_ptr _pager;
   Thread_ptr _exc_handler;
 
+  /// Translations of the capabilities this thread invoked last.
+  Cap_cache _cap_cache;
+
 protected:
   Ram_quota *_quota;
   Irq_base *_del_observer;
@@ -182,12 +188,23 @@ IMPLEMENTATION:
 #include "task.h"
 #include "thread_state.h"
 #include "timeout.h"
+#include "timer.h"
 
 FIASCO_DEFINE_KOBJ(Thread);
 
 DEFINE_PER_CPU Per_cpu<unsigned long> Thread::nested_trap_recover;
 
 
+/**
+ * Translate a capability of the thread's space through the thread's
+ * capability cache.
+ * \pre cpu lock held, this is the current thread
+ */
+PUBLIC inline
+Kobject_iface *
+Thread::lookup_cap(Cap_index idx, L4_fpage::Rights *rights)
+{ return _cap_cache.lookup(space(), idx, rights); }
+
 IMPLEMENT
 Thread::Dbg_stack::Dbg_stack()
 {
@@ -401,14 +418,18 @@ Thread::continuation_test_and_restore()
 //
 
 
-PUBLIC inline NEEDS ["config.h", "timeout.h"]
+PUBLIC inline NEEDS ["config.h", "timeout.h", "timer.h",
+                     Thread::stop_busy_tick]
 void
 Thread::handle_timer_interrupt()
 {
   Cpu_number _cpu = current_cpu();
-  // XXX: This assumes periodic timers (i.e. bogus in one-shot mode)
+  // charge the ticks skipped by a tickless timer as well
+  Unsigned32 ticks = Timer::charge_ticks(_cpu);
   if (!Config::Fine_grained_cputime)
-    consume_time(Config::Scheduler_granularity);
+    consume_time((Unsigned64)ticks * Config::Scheduler_granularity);
+
+  Sched_context::rq.cpu(_cpu).update_load();
 
   bool resched = Rcu::do_pending_work(_cpu);
 
@@ -419,6 +440,8 @@ Thread::handle_timer_interrupt()
       schedule();
       assert (timeslice_timeout.cpu(current_cpu())->is_set());	// Coma check
     }
+  else
+    stop_busy_tick(_cpu);
 }
 
 
@@ -809,7 +832,7 @@ IMPLEMENTATION [fpu && !ux]:
 /*
  * Handle FPU trap for this context. Assumes disabled interrupts
  */
-PUBLIC inline NEEDS ["fpu_alloc.h","fpu_state.h"]
+PUBLIC inline NEEDS ["fpu_alloc.h","fpu_state.h","logdefs.h"]
 int
 Thread::switchin_fpu(bool alloc_new_fpu = true)
 {
@@ -839,6 +862,8 @@ Thread::switchin_fpu(bool alloc_new_fpu = true)
 
   state_add_dirty(Thread_fpu_owner);
   f.set_owner(this);
+  fpu_mark_used();
+  CNT_FPU_TRAP;
   return 1;
 }
 
@@ -928,6 +953,38 @@ unsigned Thread::sys_fpage_unmap_log(Syscall_frame *)
 { return 0; }
 
 
+// ------------------------------------------------------------------------
+IMPLEMENTATION [!tickless]:
+
+PRIVATE inline
+void
+Thread::stop_busy_tick(Cpu_number)
+{}
+
+// ------------------------------------------------------------------------
+IMPLEMENTATION [tickless]:
+
+#include "rcupdate.h"
+#include "timer.h"
+
+/**
+ * Stop the tick while this is the only ready thread on the CPU. RCU
+ * still needs the tick, so wake up after Timer::Busy_tick_limit ticks.
+ */
+PRIVATE inline NEEDS["config.h", "rcupdate.h", "timer.h", "timeout.h"]
+void
+Thread::stop_busy_tick(Cpu_number cpu)
+{
+  if (Sched_context::rq.cpu(cpu).nr_ready() > 1 || !Rcu::idle(cpu))
+    return;
+
+  Unsigned64 limit = Timer::system_clock()
+    + Timer::Busy_tick_limit * Config::Scheduler_granularity;
+  Timer::stop_tick(cpu, Timeout_q::timeout_queue.cpu(cpu)
+                          .next_event(limit, timeslice_timeout.cpu(cpu)),
+                   true);
+}
+
 // ----------------------------------------------------------------------------
 IMPLEMENTATION [!mp]:
 
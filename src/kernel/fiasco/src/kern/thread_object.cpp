@@ -5,12 +5,46 @@ INTERFACE:
 
 class Thread_object : public Thread
 {
+public:
+  enum
+  {
+    Batch_mrs = 6,
+    Batch_max_entries = 4096,
+  };
+
+  /**
+   * Entry of the submission ring, the kernel writes the result back into
+   * the entry.
+   */
+  struct Batch_entry
+  {
+    Mword cap;            ///< capability selector and IPC operation
+    Mword tag;            ///< message tag in, result tag out
+    Mword mr[Batch_mrs];  ///< message words in, reply words out
+  };
+
+  /**
+   * Head of a submission ring in kernel-user memory, the entries follow
+   * the head.
+   */
+  struct Batch_ring
+  {
+    Mword head;  ///< next entry to execute, written by the kernel
+    Mword tail;  ///< next free entry, written by the user
+    Mword done;  ///< next result to collect, not used by the kernel
+    Mword _pad;
+  };
+
 private:
   struct Remote_syscall
   {
     Thread *thread;
     L4_msg_tag result;
   };
+
+  Ku_mem_ptr<Batch_ring> _batch_ring;
+  Mword _batch_entries;
+  bool _batch_busy;        ///< a batch submit of the thread is running
 };
 
 class Obj_cap : public L4_obj_ref
@@ -23,6 +57,7 @@ IMPLEMENTATION:
 
 #include "context.h"
 #include "fpu.h"
+#include "irq.h"
 #include "irq_chip.h"
 #include "map_util.h"
 #include "processor.h"
@@ -58,7 +93,7 @@ Obj_cap::deref(L4_fpage::Rights *rights = 0, bool dbg = false)
       return current_thread();
     }
 
-  return current->space()->lookup_local(cap(), rights);
+  return current->lookup_cap(cap(), rights);
 }
 
 PUBLIC inline NEEDS["kobject.h"]
@@ -69,10 +104,14 @@ Obj_cap::revalidate(Kobject_iface *o)
 }
 
 PUBLIC
-Thread_object::Thread_object() : Thread() {}
+Thread_object::Thread_object()
+: Thread(), _batch_entries(0), _batch_busy(false)
+{}
 
 PUBLIC
-Thread_object::Thread_object(Context_mode_kernel k) : Thread(k) {}
+Thread_object::Thread_object(Context_mode_kernel k)
+: Thread(k), _batch_entries(0), _batch_busy(false)
+{}
 
 PUBLIC virtual
 bool
@@ -159,6 +198,12 @@ Thread_object::invoke(L4_obj_ref /*self*/, L4_fpage::Rights rights, Syscall_fram
     case Op_vcpu_control:
       f->tag(sys_vcpu_control(rights, f->tag(), utcb));
       return;
+    case Op_batch_control:
+      f->tag(sys_batch_control(f->tag(), utcb));
+      return;
+    case Op_batch_submit:
+      f->tag(sys_batch_submit(f->tag(), utcb));
+      return;
     default:
       f->tag(invoke_arch(f->tag(), utcb));
       return;
@@ -513,6 +558,177 @@ Thread_object::sys_vcpu_control(L4_fpage::Rights, L4_msg_tag const &tag,
 }
 
 
+/**
+ * Register the submission ring of the thread.
+ *
+ * The ring consists of a Batch_ring head followed by a power of two number
+ * of Batch_entry slots, all in kernel-user memory of the thread's task.
+ * A ring address of zero unregisters the ring. Only the thread itself can
+ * change its ring, and not while it executes it.
+ */
+PRIVATE inline NOEXPORT
+L4_msg_tag
+Thread_object::sys_batch_control(L4_msg_tag const &tag, Utcb *utcb)
+{
+  if (EXPECT_FALSE(!space() || tag.words() < 3 || this != current()))
+    return commit_result(-L4_err::EInval);
+
+  if (EXPECT_FALSE(_batch_busy))
+    return commit_result(-L4_err::EBusy);
+
+  User<Batch_ring>::Ptr ring((Batch_ring *)utcb->values[1]);
+  Mword entries = utcb->values[2];
+
+  if (!ring)
+    {
+      _batch_entries = 0;
+      _batch_ring.set(ring, 0);
+      return commit_result(0);
+    }
+
+  if (entries == 0 || entries > Batch_max_entries
+      || (entries & (entries - 1)))
+    return commit_result(-L4_err::EInval);
+
+  Space::Ku_mem const *m
+    = space()->find_ku_mem(ring, sizeof(Batch_ring)
+                                 + entries * sizeof(Batch_entry));
+  if (!m)
+    return commit_result(-L4_err::EInval);
+
+  _batch_ring.set(ring, m->kern_addr(ring));
+  _batch_entries = entries;
+  return commit_result(0);
+}
+
+/**
+ * Can the object be invoked from a submission ring?
+ *
+ * Only kernel operations without a receive phase qualify: all task
+ * operations, IRQ operations without a receive phase, and thread ex_regs.
+ */
+PRIVATE static inline NOEXPORT NEEDS["irq.h", "task.h"]
+bool
+Thread_object::batch_invokable(Kobject_iface *o, L4_obj_ref ref,
+                               L4_msg_tag tag, Mword mr0)
+{
+  switch (tag.proto())
+    {
+    case L4_msg_tag::Label_task:
+      return Kobject::dcast<Task *>(o);
+    case L4_msg_tag::Label_irq:
+      return !ref.have_recv() && Kobject::dcast<Irq *>(o);
+    case L4_msg_tag::Label_thread:
+      return (mr0 & Opcode_mask) == Op_ex_regs && Kobject::dcast<Thread *>(o);
+    default:
+      return false;
+    }
+}
+
+/**
+ * Execute one entry of the submission ring, as if invoked by the thread
+ * with its UTCB.
+ */
+PRIVATE inline NOEXPORT
+L4_msg_tag
+Thread_object::batch_invoke(Batch_entry *e, Utcb *utcb)
+{
+  L4_obj_ref ref = L4_obj_ref::from_raw(access_once(&e->cap));
+  L4_msg_tag tag(access_once(&e->tag));
+
+  if (EXPECT_FALSE(ref.special()
+                   || (ref.op() != L4_obj_ref::Ipc_send
+                       && ref.op() != L4_obj_ref::Ipc_call_ipc)
+                   || tag.words() + 2 * tag.items() > Batch_mrs))
+    return commit_result(-L4_err::EInval);
+
+  for (unsigned i = 0; i < Batch_mrs; ++i)
+    utcb->values[i] = e->mr[i];
+
+  L4_fpage::Rights rights;
+  Kobject_iface *o = lookup_cap(ref.cap(), &rights);
+  if (EXPECT_FALSE(!o))
+    return commit_error(utcb, L4_error::Not_existent);
+
+  if (EXPECT_FALSE(!batch_invokable(o, ref, tag, utcb->values[0])))
+    return commit_result(-L4_err::EBadproto);
+
+  Syscall_frame f;
+  f.timeout(L4_timeout_pair(L4_timeout::Zero, L4_timeout::Zero));
+  f.tag(tag);
+  f.from(0);
+  f.ref(ref);
+  o->invoke(ref, rights, &f, utcb);
+
+  L4_msg_tag res = f.tag();
+  if (!ref.have_recv() && res.raw() == tag.raw())
+    return L4_msg_tag(0, 0, 0, 0);
+
+  return res;
+}
+
+/**
+ * Execute the pending entries of the thread's submission ring.
+ *
+ * The entries are executed in order, each result is written back into its
+ * entry: the result tag into the tag word, the reply words, or the error
+ * code if the result tag has the error flag set, into the message words.
+ * The kernel advances the head of the ring after every entry and checks
+ * for preemption in between.
+ *
+ * Entries run with zero timeouts but are not atomic with respect to
+ * scheduling: an ex_regs of a thread on another CPU waits for the cross-CPU
+ * request, and an IRQ trigger or a task operation may switch to another
+ * thread before the next entry runs.
+ *
+ * \return the number of executed entries in the label of the result
+ */
+PRIVATE inline NOEXPORT NEEDS["processor.h"]
+L4_msg_tag
+Thread_object::sys_batch_submit(L4_msg_tag const &, Utcb *utcb)
+{
+  // entries may block or switch, work on a snapshot of the ring
+  Mword const size = _batch_entries;
+  if (EXPECT_FALSE(this != current() || !size || _batch_busy))
+    return commit_result(-L4_err::EInval);
+
+  Batch_ring *r = _batch_ring.access(true);
+  Batch_entry *entries = reinterpret_cast<Batch_entry *>(r + 1);
+  Mword const mask = size - 1;
+  Mword head = access_once(&r->head);
+  Mword const tail = access_once(&r->tail);
+
+  if (EXPECT_FALSE(tail - head > size))
+    return commit_result(-L4_err::EInval);
+
+  write_now(&_batch_busy, true);
+  Mword n = 0;
+  while (head != tail)
+    {
+      Batch_entry *e = &entries[head++ & mask];
+      L4_msg_tag res = batch_invoke(e, utcb);
+
+      if (res.has_error())
+        e->mr[0] = utcb->error.raw();
+      else
+        for (unsigned i = 0; i < res.words() && i < Batch_mrs; ++i)
+          e->mr[i] = utcb->values[i];
+
+      e->tag = res.raw();
+      write_now(&r->head, head);
+      ++n;
+
+      // an entry may have cancelled the thread with ex_regs
+      if (EXPECT_FALSE(state() & Thread_cancel))
+        break;
+
+      Proc::preemption_point();
+    }
+
+  write_now(&_batch_busy, false);
+  return commit_result(n);
+}
+
 // -------------------------------------------------------------------
 // Thread::ex_regs class system calls
 
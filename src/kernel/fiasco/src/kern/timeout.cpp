@@ -44,16 +44,26 @@ private:
 };
 
 
+/**
+ * Hierarchical timing wheel of pending timeouts.
+ *
+ * Level 0 has one slot per Slot_shift time unit, each higher level
+ * covers the whole range of the level below with a single slot. Timeouts
+ * are put unsorted into the slot of the lowest level that covers their
+ * distance to the wheel time, so enqueue and dequeue are O(1). When the
+ * wheel time crosses a slot boundary of a higher level, the timeouts of
+ * that slot are cascaded into the lower levels.
+ */
 class Timeout_q
 {
 private:
-  /**
-   * Timeout queue count (2^n) and  distance between two queues in 2^n.
-   */
   enum
   {
-    Wakeup_queue_count	  = 8,
-    Wakeup_queue_distance = 12 // i.e. (1<<12)us
+    Slot_shift = 10,                ///< level-0 slot width is (1<<10)us
+    Level_bits = 6,
+    Num_slots  = 1 << Level_bits,   ///< slots per level
+    Slot_mask  = Num_slots - 1,
+    Num_levels = 4,                 ///< the wheel spans 2^34us, about 4.7h
   };
 
   typedef Timeout::To_list To_list;
@@ -61,15 +71,25 @@ private:
   typedef To_list::Const_iterator Const_iterator;
 
   /**
-   * The timeout queues.
+   * The timeout slots, _q[level * Num_slots + slot].
+   */
+  To_list _q[Num_levels * Num_slots];
+
+  /**
+   * Per level bitmap of possibly non-empty slots. Timeout::reset() does
+   * not know about the wheel, so a set bit may refer to an empty slot.
    */
-  To_list _q[Wakeup_queue_count];
+  Unsigned64 _occupied[Num_levels];
+
+  /**
+   * The wheel time in level-0 slots, everything before has been expired.
+   */
+  Unsigned64 _now;
 
   /**
    * The current programmed timeout.
    */
   Unsigned64 _current;
-  Unsigned64 _old_clock;
 
 public:
   static Per_cpu<Timeout_q> timeout_queue;
@@ -92,37 +112,80 @@ IMPLEMENTATION:
 DEFINE_PER_CPU Per_cpu<Timeout_q> Timeout_q::timeout_queue;
 
 
+/**
+ * Access a slot of the wheel by its flat index, level 0 first.
+ */
 PUBLIC inline
 Timeout_q::To_list &
 Timeout_q::first(int index)
-{ return _q[index & (Wakeup_queue_count-1)]; }
+{ return _q[index & (Num_levels * Num_slots - 1)]; }
 
 PUBLIC inline
 Timeout_q::To_list const &
 Timeout_q::first(int index) const
-{ return _q[index & (Wakeup_queue_count-1)]; }
+{ return _q[index & (Num_levels * Num_slots - 1)]; }
 
 PUBLIC inline
 unsigned
-Timeout_q::queues() const { return Wakeup_queue_count; }
+Timeout_q::queues() const { return Num_levels * Num_slots; }
+
+PUBLIC static inline
+unsigned
+Timeout_q::levels() { return Num_levels; }
 
+PUBLIC static inline
+unsigned
+Timeout_q::slots_per_level() { return Num_slots; }
 
 /**
- * Enqueue a new timeout.
+ * Width of a slot on the given level in microseconds.
  */
-PUBLIC inline NEEDS[Timeout_q::first, "timer.h", "config.h"]
+PUBLIC static inline
+Unsigned64
+Timeout_q::slot_width(unsigned level)
+{ return 1ULL << (Slot_shift + level * Level_bits); }
+
+PRIVATE inline
+Timeout_q::To_list &
+Timeout_q::slot(unsigned level, unsigned idx)
+{ return _q[level * Num_slots + idx]; }
+
+/**
+ * Put a timeout into the slot matching its distance to the wheel time.
+ */
+PRIVATE inline NEEDS[Timeout_q::slot]
 void
-Timeout_q::enqueue(Timeout *to)
+Timeout_q::insert(Timeout *to)
 {
-  int queue = (to->_wakeup >> Wakeup_queue_distance) & (Wakeup_queue_count-1);
+  Unsigned64 t = to->_wakeup >> Slot_shift;
 
-  To_list &q = first(queue);
-  Iterator tmp = q.begin();
+  // already due, expire with the current slot
+  if (t < _now)
+    t = _now;
 
-  while (tmp != q.end() && tmp->_wakeup < to->_wakeup)
-    ++tmp;
+  Unsigned64 delta = t - _now;
+  unsigned level = 0;
+  while (level < Num_levels - 1 && delta >= (1ULL << ((level + 1) * Level_bits)))
+    ++level;
+
+  // beyond the range of the wheel, park it in the farthest slot, it gets
+  // cascaded down again and again until it is in range
+  if (EXPECT_FALSE(delta >= (1ULL << (Num_levels * Level_bits))))
+    t = _now + (1ULL << (Num_levels * Level_bits)) - 1;
+
+  unsigned idx = (t >> (level * Level_bits)) & Slot_mask;
+  slot(level, idx).add(to);
+  _occupied[level] |= 1ULL << idx;
+}
 
-  q.insert_before(to, tmp);
+/**
+ * Enqueue a new timeout.
+ */
+PUBLIC inline NEEDS[Timeout_q::insert, "timer.h", "config.h"]
+void
+Timeout_q::enqueue(Timeout *to)
+{
+  insert(to);
 
   if (Config::Scheduler_one_shot && (to->_wakeup <= _current))
     {
@@ -184,7 +247,7 @@ Timeout::has_hit()
 }
 
 
-PUBLIC inline NEEDS [<cassert>, "cpu_lock.h", "lock_guard.h",
+PUBLIC inline NEEDS [<cassert>, "cpu_lock.h", "lock_guard.h", "timer.h",
                      Timeout_q::enqueue, Timeout::is_set]
 void
 Timeout::set(Unsigned64 clock, Cpu_number cpu)
@@ -196,6 +259,7 @@ Timeout::set(Unsigned64 clock, Cpu_number cpu)
 
   _wakeup = clock;
   Timeout_q::timeout_queue.cpu(cpu).enqueue(this);
+  Timer::tick_needed(cpu, clock);
 }
 
 /**
@@ -208,7 +272,7 @@ Timeout::get_timeout(Unsigned64 clock)
   return _wakeup - clock;
 }
 
-PUBLIC inline NEEDS [<cassert>, "cpu_lock.h", "lock_guard.h",
+PUBLIC inline NEEDS [<cassert>, "cpu_lock.h", "lock_guard.h", "timer.h",
                      Timeout::is_set, Timeout_q::enqueue, Timeout::has_hit]
 void
 Timeout::set_again(Cpu_number cpu)
@@ -221,6 +285,7 @@ Timeout::set_again(Cpu_number cpu)
     return;
 
   Timeout_q::timeout_queue.cpu(cpu).enqueue(this);
+  Timer::tick_needed(cpu, _wakeup);
 }
 
 PUBLIC inline NEEDS ["cpu_lock.h", "lock_guard.h", "timer.h",
@@ -263,113 +328,258 @@ Timeout::dequeue(bool is_expired = true)
 }
 
 /**
- * Handles the timeouts, i.e. call expired() for the expired timeouts
- * and programs the "oneshot timer" to the next timeout.
+ * Expire all timeouts of the current level-0 slot that are due at \a clock.
  * @return true if a reschedule is necessary, false otherwise.
  */
-PUBLIC inline NEEDS [<cassert>, <climits>, "kip.h", "timer.h", "config.h",
-                     Timeout::expire]
+PRIVATE inline NEEDS [Timeout::expire, Timeout_q::slot]
 bool
-Timeout_q::do_timeouts()
+Timeout_q::expire_slot(Unsigned64 clock)
 {
+  unsigned idx = _now & Slot_mask;
+  To_list &q = slot(0, idx);
   bool reschedule = false;
 
-  // We test if the time between 2 activiations of this function is greater
-  // than the distance between two timeout queues.
-  // To avoid to lose timeouts, we calculating the missed queues and
-  // scan them too.
-  // This can only happen, if we dont enter the timer interrupt for a long
-  // time, usual with one shot timer.
-  // Because we initalize old_dequeue_time with zero,
-  // we can get an "miss" on the first timerinterrupt.
-  // But this is booting the system, which is uncritical.
+  // Detach the slot first, expired() handlers may reset other timeouts
+  // or enqueue new ones.
+  To_list pending;
+  while (!q.empty())
+    {
+      Timeout *to = q.front();
+      To_list::remove(to);
+      pending.add(to);
+    }
+
+  while (!pending.empty())
+    {
+      Timeout *to = pending.front();
+      To_list::remove(to);
+      if (to->_wakeup <= clock)
+        reschedule |= to->expire();
+      else
+        q.add(to);
+    }
+
+  if (q.empty())
+    _occupied[0] &= ~(1ULL << idx);
+
+  return reschedule;
+}
+
+/**
+ * Move the timeouts of the higher-level slots that start at the current
+ * wheel time down to the lower levels.
+ */
+PRIVATE inline NEEDS [Timeout_q::insert, Timeout_q::slot]
+void
+Timeout_q::cascade()
+{
+  for (unsigned level = 1; level < Num_levels; ++level)
+    {
+      unsigned idx = (_now >> (level * Level_bits)) & Slot_mask;
+      if (_occupied[level] & (1ULL << idx))
+        {
+          _occupied[level] &= ~(1ULL << idx);
+          To_list &q = slot(level, idx);
+          while (!q.empty())
+            {
+              Timeout *to = q.front();
+              To_list::remove(to);
+              insert(to);
+            }
+        }
 
-  // Calculate which timeout queues needs to be checked.
-  int start = (_old_clock >> Wakeup_queue_distance);
-  int diff  = (Kip::k()->clock >> Wakeup_queue_distance) - start;
-  int end   = (start + diff + 1) & (Wakeup_queue_count - 1);
+      if (idx)
+        break;
+    }
+}
 
-  // wrap around
-  start = start & (Wakeup_queue_count - 1);
+/**
+ * The next wheel time after the current one with an occupied level-0
+ * slot or an occupied higher-level slot to cascade.
+ * @return the wheel time, or ULONG_LONG_MAX if the wheel is empty.
+ */
+PRIVATE inline NEEDS [<climits>]
+Unsigned64
+Timeout_q::next_stop() const
+{
+  Unsigned64 next = ULONG_LONG_MAX;
+  for (unsigned l = 0; l < Num_levels; ++l)
+    {
+      Unsigned64 o = _occupied[l];
+      if (!o)
+        continue;
+
+      unsigned shift = l * Level_bits;
+      unsigned i = (_now >> shift) & Slot_mask;
+      Unsigned64 r = i ? (o >> i) | (o << (Num_slots - i)) : o;
+
+      // the slot of the current index is done, anything left in there
+      // belongs to the next rotation
+      unsigned k = (r & ~1ULL) ? __builtin_ctzll(r & ~1ULL) : Num_slots;
+      Unsigned64 t = ((_now >> shift) + k) << shift;
+      if (t < next)
+        next = t;
+    }
 
-  // test if an complete miss
-  if (diff >= Wakeup_queue_count)
-    start = end = 0; // scan all queues
+  return next;
+}
 
-  // update old_clock for the next run
-  _old_clock = Kip::k()->clock;
+/**
+ * Handles the timeouts, i.e. call expired() for the expired timeouts
+ * and programs the "oneshot timer" to the next timeout.
+ *
+ * The wheel jumps from one occupied level-0 slot or occupied cascade
+ * point to the next, so the work depends on the number of expired and
+ * cascaded timeouts only, not on the elapsed time, e.g. after the tick
+ * was stopped for a long time.
+ * @return true if a reschedule is necessary, false otherwise.
+ */
+PUBLIC inline NEEDS [<cassert>, <climits>, "kip.h", "timer.h", "config.h",
+                     Timeout_q::expire_slot, Timeout_q::cascade,
+                     Timeout_q::next_stop, Timeout_q::next_event]
+bool
+Timeout_q::do_timeouts()
+{
+  bool reschedule = false;
+  Unsigned64 clock = Kip::k()->clock;
+  Unsigned64 target = clock >> Slot_shift;
 
-  // ensure we always terminate
-  assert((end >= 0) && (end < Wakeup_queue_count));
+  if (EXPECT_FALSE(target < _now))
+    target = _now;
 
   for (;;)
     {
-      To_list &q = first(start);
-      Iterator timeout = q.begin();
+      if (_occupied[0] & (1ULL << (_now & Slot_mask)))
+        reschedule |= expire_slot(clock);
+
+      if (_now == target)
+        break;
 
-      // now scan this queue for timeouts below current clock
-      while (timeout != q.end() && timeout->_wakeup <= (Kip::k()->clock))
+      // skip the empty slots and the cascade points without anything
+      // to cascade in between
+      Unsigned64 next = next_stop();
+      if (next > target)
         {
-          Timeout *to = *timeout;
-          timeout = q.erase(timeout);
-          reschedule |= to->expire();
+          _now = target;
+          continue;
         }
 
-      // next queue
-      start = (start + 1) & (Wakeup_queue_count - 1);
-
-      if (start == end)
-	break;
+      _now = next;
+      if (!(_now & Slot_mask))
+        cascade();
     }
 
   if (Config::Scheduler_one_shot)
     {
-      // scan all queues for the next minimum
-      //_current = (Unsigned64) ULONG_LONG_MAX;
-      _current = Kip::k()->clock + 10000; //ms
-      bool update_timer = true;
-
-      for (int i = 0; i < Wakeup_queue_count; i++)
-	{
-	  // make sure that something enqueued other than the dummy element
-	  if (first(i).empty())
-	    continue;
+      _current = next_event(clock + 10000); //ms
+      Timer::update_timer(_current);
+    }
 
-	  update_timer = true;
+  return reschedule;
+}
 
-	  if (first(i).front()->_wakeup < _current)
-	    _current =  first(i).front()->_wakeup;
-	}
+/**
+ * Earliest point in time where the wheel needs attention, either because
+ * a timeout expires or because higher-level timeouts must be cascaded.
+ * @param limit   value to return if nothing happens earlier
+ * @param ignore  timeout that shall not be considered, may be 0
+ */
+PUBLIC inline
+Unsigned64
+Timeout_q::next_event(Unsigned64 limit, Timeout const *ignore = 0) const
+{
+  Unsigned64 ev = limit;
 
-      if (update_timer)
-	Timer::update_timer(_current);
+  // level 0: the first occupied slot holds the earliest timeouts
+  unsigned idx = _now & Slot_mask;
+  Unsigned64 occ = _occupied[0];
+  Unsigned64 rot = idx ? (occ >> idx) | (occ << (Num_slots - idx)) : occ;
+  while (rot)
+    {
+      unsigned k = __builtin_ctzll(rot);
+      rot &= rot - 1;
+      To_list const &q = _q[(idx + k) & Slot_mask];
+      bool found = false;
+      for (Const_iterator i = q.begin(); i != q.end(); ++i)
+        if (*i != ignore)
+          {
+            found = true;
+            if (i->_wakeup < ev)
+              ev = i->_wakeup;
+          }
+
+      if (found)
+        break;
+    }
 
+  // higher levels: the cascade point of the next occupied slot
+  for (unsigned l = 1; l < Num_levels; ++l)
+    {
+      unsigned shift = l * Level_bits;
+      unsigned i = (_now >> shift) & Slot_mask;
+      Unsigned64 o = _occupied[l];
+      Unsigned64 r = i ? (o >> i) | (o << (Num_slots - i)) : o;
+      if (!r)
+        continue;
+
+      // the slot of the current index was cascaded already, anything in
+      // there belongs to the next rotation
+      unsigned k = (r & ~1ULL) ? __builtin_ctzll(r & ~1ULL) : Num_slots;
+      Unsigned64 t = (((_now >> shift) + k) << shift) << Slot_shift;
+      if (t < ev)
+        ev = t;
     }
-  return reschedule;
+
+  return ev;
 }
 
 PUBLIC inline
 Timeout_q::Timeout_q()
-: _current(ULONG_LONG_MAX), _old_clock(0)
-{}
+: _now(0), _current(ULONG_LONG_MAX)
+{
+  for (unsigned l = 0; l < Num_levels; ++l)
+    _occupied[l] = 0;
+}
 
 PUBLIC inline
 bool
 Timeout_q::have_timeouts(Timeout const *ignore) const
 {
-  for (unsigned i = 0; i < Wakeup_queue_count; ++i)
-    {
-      To_list const &t = first(i);
-      if (!t.empty())
-        {
-          To_list::Const_iterator f = t.begin();
-          if (*f == ignore && (++f) == t.end())
-            continue;
-
-          return true;
-        }
-    }
+  for (unsigned l = 0; l < Num_levels; ++l)
+    for (Unsigned64 o = _occupied[l]; o; o &= o - 1)
+      {
+        To_list const &t = _q[l * Num_slots + __builtin_ctzll(o)];
+        if (!t.empty())
+          {
+            To_list::Const_iterator f = t.begin();
+            if (*f == ignore && (++f) == t.end())
+              continue;
+
+            return true;
+          }
+      }
 
   return false;
 }
 
+/**
+ * Number of timeouts in a slot, for debugging only.
+ */
+PUBLIC
+unsigned
+Timeout_q::slot_length(unsigned level, unsigned idx) const
+{
+  unsigned n = 0;
+  To_list const &q = _q[level * Num_slots + idx];
+  for (Const_iterator i = q.begin(); i != q.end(); ++i)
+    ++n;
+  return n;
+}
+
+/**
+ * The slot the wheel time currently points to on the given level.
+ */
+PUBLIC inline
+unsigned
+Timeout_q::current_slot(unsigned level) const
+{ return (_now >> (level * Level_bits)) & Slot_mask; }
@@ -54,3 +54,58 @@ IMPLEMENT_DEFAULT
 void
 Timer::enable()
 {}
+
+// ------------------------------------------------------------------------
+INTERFACE [tickless]:
+
+EXTENSION class Timer
+{
+public:
+  /// Max. number of ticks skipped while a thread is running.
+  enum { Busy_tick_limit = 10 };
+
+  /**
+   * Stop the periodic tick on `cpu` until `wakeup`.
+   *
+   * Must be called on `cpu` with the CPU lock held.
+   * \param busy  true if a thread keeps running on the CPU
+   * \return true if the tick is stopped, false if ticking on is cheaper
+   *         or required.
+   */
+  static bool stop_tick(Cpu_number cpu, Unsigned64 wakeup, bool busy);
+
+  /**
+   * Account the ticks suppressed so far and resume the periodic tick.
+   */
+  static void restart_tick(Cpu_number cpu);
+
+  /**
+   * Number of ticks suppressed on `cpu` since boot.
+   */
+  static Unsigned64 suppressed_ticks(Cpu_number cpu);
+
+  /**
+   * Number of ticks elapsed on `cpu` up to the last timer interrupt and
+   * not yet charged to a thread; resets the count.
+   */
+  static Unsigned32 charge_ticks(Cpu_number cpu);
+};
+
+// ------------------------------------------------------------------------
+IMPLEMENTATION [!tickless]:
+
+/**
+ * Something on `cpu` needs the tick at `wakeup` at the latest.
+ */
+PUBLIC static inline
+void
+Timer::tick_needed(Cpu_number, Unsigned64)
+{}
+
+/**
+ * Every timer interrupt accounts exactly one tick.
+ */
+PUBLIC static inline
+Unsigned32
+Timer::charge_ticks(Cpu_number)
+{ return 1; }
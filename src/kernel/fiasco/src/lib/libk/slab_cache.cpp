@@ -4,6 +4,7 @@ INTERFACE:
 #include <cxx/hlist>
 #include <cxx/slist>
 #include <auto_quota.h>
+#include <per_cpu_data.h>
 
 // The anonymous slab allocator.  You can specialize this allocator by
 // providing your own initialization functions and your own low-level
@@ -53,6 +54,77 @@ private:
   typedef Spin_lock<> Lock;
   Lock lock;
   char const *_name;
+
+  //
+  // Per-CPU magazines in front of the slabs (Bonwick-style). Each CPU
+  // owns a loaded and a previous magazine that are either full or empty
+  // (previous) or anything in between (loaded). Full magazines are
+  // exchanged with a shared depot, so the slab lock is only taken when
+  // the depot runs dry or overflows.
+  //
+public:
+  enum
+  {
+    Mag_rounds = 16, ///< objects per magazine
+    Depot_max  = 16, ///< max. number of full magazines in the depot
+  };
+
+  struct Mag_stats
+  {
+    unsigned long hits;   ///< allocations served from a magazine
+    unsigned long misses; ///< allocations that went to the slabs
+    unsigned rounds;      ///< objects in the CPU's magazines
+  };
+
+private:
+  /// Free object linked into a magazine.
+  struct Mag_obj
+  {
+    Mag_obj *next;      ///< next object in the same magazine
+    Mag_obj *next_mag;  ///< next magazine in the depot (top object only)
+  };
+
+  struct Magazine
+  {
+    Mag_obj *top;
+    unsigned rounds;
+
+    Magazine() : top(0), rounds(0) {}
+    bool empty() const { return !rounds; }
+    bool full() const { return rounds == Mag_rounds; }
+
+    void push(void *o)
+    {
+      Mag_obj *m = reinterpret_cast<Mag_obj *>(o);
+      m->next = top;
+      top = m;
+      ++rounds;
+    }
+
+    void *pop()
+    {
+      Mag_obj *m = top;
+      top = m->next;
+      --rounds;
+      return m;
+    }
+  };
+
+  struct Cpu_cache
+  {
+    Magazine loaded, previous;
+    unsigned long trim_gen;
+    unsigned long hits, misses;
+
+    Cpu_cache() : trim_gen(0), hits(0), misses(0) {}
+  } __attribute__((aligned(Config::Cache_line_size)));
+
+  Per_cpu_array<Cpu_cache> _cpu;
+  Mag_obj *_depot;
+  unsigned _depot_mags;
+  unsigned long _trim_gen;
+  bool _use_mags;
+  Lock _depot_lock;
 };
 
 
@@ -62,6 +134,9 @@ IMPLEMENTATION:
 #include <cstddef>
 #include <cstdlib>
 #include <lock_guard.h>
+#include <atomic.h>
+#include <context_base.h>
+#include <cpu_lock.h>
 
 // default deallocator must not be called -- must use explicit destruction
 inline NOEXPORT
@@ -157,9 +232,11 @@ Slab_cache::Slab_cache(unsigned elem_size,
 				 unsigned long min_size,
 				 unsigned long max_size)
   : _entry_size(entry_size(elem_size, alignment)), _num_empty(0),
-    _name (name)
+    _name (name), _depot(0), _depot_mags(0), _trim_gen(0),
+    _use_mags(_entry_size >= sizeof(Mag_obj))
 {
   lock.init();
+  _depot_lock.init();
 
   for (
       _slab_size = min_size;
@@ -179,9 +256,11 @@ Slab_cache::Slab_cache(unsigned long slab_size,
 				 unsigned alignment,
 				 char const * name)
   : _slab_size(slab_size), _entry_size(entry_size(elem_size, alignment)),
-    _num_empty(0), _name (name)
+    _num_empty(0), _name (name), _depot(0), _depot_mags(0), _trim_gen(0),
+    _use_mags(_entry_size >= sizeof(Mag_obj))
 {
   lock.init();
+  _depot_lock.init();
   _elem_num = (_slab_size - sizeof(Slab)) / _entry_size;
 }
 
@@ -218,9 +297,9 @@ Slab_cache::get_available_locked()
   return s;
 }
 
-PUBLIC
+PRIVATE
 void *
-Slab_cache::alloc()	// request initialized member from cache
+Slab_cache::alloc_slab()
 {
   void *unused_block = 0;
   void *ret;
@@ -273,6 +352,247 @@ Slab_cache::alloc()	// request initialized member from cache
   return ret;
 }
 
+//
+// Magazine layer
+//
+
+/**
+ * Move the magazines of `c` to the list `mags` (linked like the depot).
+ * \pre CPU lock held, `c` is the cache of the current CPU
+ */
+PRIVATE static inline
+void
+Slab_cache::detach_magazines(Cpu_cache *c, Mag_obj **mags)
+{
+  Magazine *m[2] = { &c->loaded, &c->previous };
+  for (unsigned i = 0; i < 2; ++i)
+    if (!m[i]->empty())
+      {
+        m[i]->top->next_mag = *mags;
+        *mags = m[i]->top;
+        *m[i] = Magazine();
+      }
+}
+
+/**
+ * Return all objects of a list of magazines to the slabs.
+ * \pre CPU lock not held
+ */
+PRIVATE
+void
+Slab_cache::free_magazines(Mag_obj *mags)
+{
+  while (mags)
+    {
+      Mag_obj *o = mags;
+      mags = o->next_mag;
+      while (o)
+        {
+          Mag_obj *n = o->next;
+          free_slab(o);
+          o = n;
+        }
+    }
+}
+
+/**
+ * The magazines of the current CPU after a pending trim request has been
+ * honoured. Magazines to be flushed are added to `flush`.
+ * \pre CPU lock held
+ */
+PRIVATE inline NEEDS[<context_base.h>, <atomic.h>,
+                     Slab_cache::detach_magazines]
+Slab_cache::Cpu_cache *
+Slab_cache::cpu_cache(Mag_obj **flush)
+{
+  Cpu_cache *c = &_cpu[current_cpu()];
+  unsigned long gen = access_once(&_trim_gen);
+  if (EXPECT_FALSE(c->trim_gen != gen))
+    {
+      c->trim_gen = gen;
+      detach_magazines(c, flush);
+    }
+  return c;
+}
+
+/**
+ * Take an object from the magazines of `c`, refilling them from the
+ * depot if necessary.
+ * \pre CPU lock held
+ */
+PRIVATE inline NEEDS[<lock_guard.h>]
+void *
+Slab_cache::mag_alloc(Cpu_cache *c)
+{
+  if (EXPECT_TRUE(!c->loaded.empty()))
+    return c->loaded.pop();
+
+  if (c->previous.full())
+    {
+      Magazine t = c->loaded;
+      c->loaded = c->previous;
+      c->previous = t;
+      return c->loaded.pop();
+    }
+
+  auto guard = lock_guard(_depot_lock);
+  Mag_obj *m = _depot;
+  if (!m)
+    return 0;
+
+  _depot = m->next_mag;
+  --_depot_mags;
+
+  // loaded and previous are both empty here
+  c->loaded.top = m;
+  c->loaded.rounds = Mag_rounds;
+  return c->loaded.pop();
+}
+
+/**
+ * Put an object into the magazines of `c`, handing a full magazine to
+ * the depot if necessary.
+ * \pre CPU lock held
+ * \return false if the depot is full and the object must go to the slabs
+ */
+PRIVATE inline NEEDS[<lock_guard.h>]
+bool
+Slab_cache::mag_free(Cpu_cache *c, void *o)
+{
+  if (EXPECT_TRUE(!c->loaded.full()))
+    {
+      c->loaded.push(o);
+      return true;
+    }
+
+  if (c->previous.empty())
+    {
+      Magazine t = c->loaded;
+      c->loaded = c->previous;
+      c->previous = t;
+      c->loaded.push(o);
+      return true;
+    }
+
+  {
+    auto guard = lock_guard(_depot_lock);
+    if (_depot_mags >= Depot_max)
+      return false;
+
+    c->previous.top->next_mag = _depot;
+    _depot = c->previous.top;
+    ++_depot_mags;
+  }
+
+  c->previous = c->loaded;
+  c->loaded = Magazine();
+  c->loaded.push(o);
+  return true;
+}
+
+PUBLIC
+void *
+Slab_cache::alloc()	// request initialized member from cache
+{
+  Mag_obj *flush = 0;
+
+  if (EXPECT_TRUE(_use_mags))
+    {
+      auto guard = lock_guard(cpu_lock);
+      Cpu_cache *c = cpu_cache(&flush);
+      if (void *o = mag_alloc(c))
+        {
+          ++c->hits;
+          return o;
+        }
+      ++c->misses;
+    }
+
+  if (EXPECT_FALSE(flush != 0))
+    free_magazines(flush);
+
+  return alloc_slab();
+}
+
+PUBLIC
+void
+Slab_cache::free(void *cache_entry) // return initialized member to cache
+{
+  Mag_obj *flush = 0;
+
+  if (EXPECT_TRUE(_use_mags))
+    {
+      auto guard = lock_guard(cpu_lock);
+      Cpu_cache *c = cpu_cache(&flush);
+      // while trimming the object goes directly to the slabs
+      if (EXPECT_TRUE(!flush) && mag_free(c, cache_entry))
+        return;
+    }
+
+  if (EXPECT_FALSE(flush != 0))
+    free_magazines(flush);
+
+  free_slab(cache_entry);
+}
+
+/**
+ * Return the depot and the magazines of the current CPU to the slabs and
+ * ask all other CPUs to flush their magazines on their next operation.
+ */
+PUBLIC
+void
+Slab_cache::trim_magazines()
+{
+  if (!_use_mags)
+    return;
+
+  Mag_obj *mags = 0;
+    {
+      auto guard = lock_guard(cpu_lock);
+      write_now(&_trim_gen, _trim_gen + 1);
+      cpu_cache(&mags);
+
+      auto depot_guard = lock_guard(_depot_lock);
+      Mag_obj *last = _depot;
+      if (last)
+        {
+          while (last->next_mag)
+            last = last->next_mag;
+          last->next_mag = mags;
+          mags = _depot;
+        }
+      _depot = 0;
+      _depot_mags = 0;
+    }
+
+  free_magazines(mags);
+}
+
+/**
+ * Magazine statistics of `cpu`, for debugging only.
+ */
+PUBLIC
+Slab_cache::Mag_stats
+Slab_cache::mag_stats(Cpu_number cpu) const
+{
+  Cpu_cache const *c = &_cpu[cpu];
+  Mag_stats s;
+  s.hits = c->hits;
+  s.misses = c->misses;
+  s.rounds = c->loaded.rounds + c->previous.rounds;
+  return s;
+}
+
+PUBLIC inline
+unsigned
+Slab_cache::depot_magazines() const
+{ return _depot_mags; }
+
+PUBLIC inline
+char const *
+Slab_cache::name() const
+{ return _name; }
+
 PUBLIC template< typename Q >
 inline
 void *
@@ -290,9 +610,9 @@ Slab_cache::q_alloc(Q *quota)
   return r;
 }
 
-PUBLIC
+PRIVATE
 void
-Slab_cache::free(void *cache_entry) // return initialized member to cache
+Slab_cache::free_slab(void *cache_entry)
 {
   Slab *to_free = 0;
     {
@@ -352,6 +672,8 @@ Slab_cache::reap()		// request that cache returns memory to system
   Slab *s = 0;
   unsigned long sz = 0;
 
+  trim_magazines();
+
   for (;;)
     {
 	{
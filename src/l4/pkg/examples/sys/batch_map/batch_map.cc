@@ -0,0 +1,137 @@
+/**
+ * \file
+ * \brief Map burst benchmark for the submission ring.
+ *
+ * Maps bursts of 1000 pages into an empty task, once with one
+ * l4_task_map() system call per page and once queued in the thread's
+ * submission ring and executed with a single l4_thread_batch_submit().
+ * The target task is emptied again between the bursts.
+ */
+/*
+ * This file is distributed under the terms of the GNU General Public
+ * License 2. Please see the COPYING-GPL-2 file for details.
+ */
+#include <l4/re/env>
+#include <l4/re/env.h>
+#include <l4/re/rm>
+#include <l4/re/dataspace>
+#include <l4/re/util/cap_alloc>
+#include <l4/re/util/kumem_alloc>
+#include <l4/sys/batch.h>
+#include <l4/sys/factory>
+#include <l4/sys/kip.h>
+#include <l4/sys/task>
+#include <l4/sys/thread>
+
+#include <stdio.h>
+
+enum
+{
+  Maps    = 1000,
+  Rounds  = 20,
+  Entries = 1024,
+  Dst     = 0x10000000, // where the pages go in the target task
+};
+
+static char *buf;
+static L4::Cap<L4::Task> dst;
+static l4_batch_ring_t *ring;
+
+static l4_fpage_t page(unsigned i)
+{ return l4_fpage((l4_addr_t)buf + i * L4_PAGESIZE, L4_PAGESHIFT, L4_FPAGE_RWX); }
+
+static void clear_dst()
+{
+  dst->unmap(l4_fpage(0, L4_WHOLE_ADDRESS_SPACE, L4_FPAGE_RWX),
+             L4_FP_ALL_SPACES);
+}
+
+static unsigned map_single()
+{
+  unsigned errors = 0;
+  for (unsigned i = 0; i < Maps; ++i)
+    if (l4_error(dst->map(L4Re::This_task, page(i), Dst + i * L4_PAGESIZE)))
+      ++errors;
+  return errors;
+}
+
+static unsigned map_batched()
+{
+  L4::Cap<L4::Thread> self = L4Re::Env::env()->main_thread();
+  unsigned errors = 0;
+
+  for (unsigned i = 0; i < Maps; ++i)
+    if (l4_batch_task_map(ring, Entries, dst.cap(), L4RE_THIS_TASK_CAP,
+                          page(i), Dst + i * L4_PAGESIZE))
+      ++errors;
+
+  if (l4_msgtag_label(self->batch_submit()) != Maps)
+    ++errors;
+
+  while (l4_batch_entry_t *e = l4_batch_pop(ring, Entries))
+    if (l4_error(l4_batch_result(e)))
+      ++errors;
+
+  return errors;
+}
+
+static void bench(char const *name, unsigned (*burst)())
+{
+  l4_kernel_info_t *kip = l4re_kip();
+  l4_cpu_time_t t = 0;
+  unsigned errors = 0;
+
+  for (unsigned r = 0; r < Rounds; ++r)
+    {
+      clear_dst();
+      l4_cpu_time_t start = l4_kip_clock(kip);
+      errors += burst();
+      t += l4_kip_clock(kip) - start;
+    }
+
+  printf("%-10s %6llu ns per map, %6llu us per burst (%u errors)\n", name,
+         (unsigned long long)t * 1000 / (Rounds * Maps),
+         (unsigned long long)t / Rounds, errors);
+}
+
+int main()
+{
+  L4Re::Env const *env = L4Re::Env::env();
+
+  L4::Cap<L4Re::Dataspace> ds = L4Re::Util::cap_alloc.alloc<L4Re::Dataspace>();
+  dst = L4Re::Util::cap_alloc.alloc<L4::Task>();
+  if (!ds.is_valid() || !dst.is_valid())
+    return 1;
+
+  if (env->mem_alloc()->alloc(Maps * L4_PAGESIZE, ds)
+      || env->rm()->attach(&buf, Maps * L4_PAGESIZE,
+                           L4Re::Rm::Search_addr | L4Re::Rm::Eager_map, ds))
+    return 1;
+
+  if (l4_error(env->factory()->create_task(dst, l4_fpage_invalid())))
+    return 1;
+
+  unsigned order = 0;
+  while ((L4_PAGESIZE << order) < l4_batch_ring_size(Entries))
+    ++order;
+
+  l4_addr_t kumem;
+  if (L4Re::Util::kumem_alloc(&kumem, order))
+    return 1;
+
+  ring = (l4_batch_ring_t *)kumem;
+  l4_batch_init(ring);
+  if (l4_error(env->main_thread()->batch_control(kumem, Entries)))
+    {
+      printf("Kernel does not support submission rings\n");
+      return 1;
+    }
+
+  // the source pages must be present to be mapped
+  for (unsigned i = 0; i < Maps; ++i)
+    buf[i * L4_PAGESIZE] = 1;
+
+  bench("single:", map_single);
+  bench("batched:", map_batched);
+  return 0;
+}
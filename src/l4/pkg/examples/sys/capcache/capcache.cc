@@ -0,0 +1,100 @@
+/**
+ * \file
+ * \brief Capability lookup benchmark.
+ *
+ * Triggers an unbound IRQ object, which the kernel handles without any
+ * further work, so the cost is dominated by the system call and the
+ * capability lookup. The first run always uses the same capability and
+ * hits in the kernel's per-thread capability cache. The second run
+ * alternates between two capabilities for the same IRQ whose indexes
+ * share a cache slot, so every invocation takes the uncached path.
+ */
+/*
+ * This file is distributed under the terms of the GNU General Public
+ * License 2. Please see the COPYING-GPL-2 file for details.
+ */
+#include <l4/re/env>
+#include <l4/re/error_helper>
+#include <l4/re/util/cap_alloc>
+#include <l4/sys/factory>
+#include <l4/sys/irq>
+#include <l4/sys/task>
+
+#include <stdio.h>
+
+#if !defined(__mips__)
+#include <l4/util/rdtsc.h>
+#endif
+
+enum
+{
+  Rounds = 100000,
+  Warmup = 1000,
+  // a multiple of any cache size the kernel may use
+  Slot_stride = 64,
+};
+
+static inline l4_uint32_t cycles()
+{
+#if defined(__mips__)
+  l4_uint32_t c;
+  asm volatile (".set push; .set mips32r2; rdhwr %0, $2; .set pop" : "=r" (c));
+  return c;
+#else
+  return l4_rdtsc_32();
+#endif
+}
+
+static void bench(L4::Cap<L4::Irq> a, L4::Cap<L4::Irq> b, char const *name)
+{
+  l4_uint32_t start = 0;
+  L4::Cap<L4::Irq> caps[2] = { a, b };
+
+  for (unsigned r = 0; r < Warmup + Rounds; ++r)
+    {
+      if (r == Warmup)
+        start = cycles();
+
+      caps[r & 1]->trigger();
+    }
+  l4_uint32_t t = cycles() - start;
+
+  printf("%-10s %6u cycles per invocation (%u rounds)\n",
+         name, t / Rounds, (unsigned)Rounds);
+}
+
+static unsigned long slot(L4::Cap<void> c)
+{ return (c.cap() >> L4_CAP_SHIFT) % Slot_stride; }
+
+int main()
+{
+  try
+    {
+      L4Re::Env const *env = L4Re::Env::env();
+      L4::Cap<L4::Irq> irq
+        = L4Re::chkcap(L4Re::Util::cap_alloc.alloc<L4::Irq>(),
+                       "Cannot allocate IRQ capability");
+      L4Re::chksys(env->factory()->create_irq(irq), "Cannot create IRQ");
+
+      // find a free capability index that shares the cache slot of irq
+      L4::Cap<L4::Irq> alias;
+      do
+        alias = L4Re::chkcap(L4Re::Util::cap_alloc.alloc<L4::Irq>(),
+                             "Cannot allocate alias capability");
+      while (slot(alias) != slot(irq));
+
+      L4Re::chksys(env->task()->map(env->task(),
+                                    irq.fpage(L4_FPAGE_RWX),
+                                    alias.snd_base()),
+                   "Cannot map IRQ alias");
+
+      bench(irq, irq, "cached:");
+      bench(irq, alias, "uncached:");
+    }
+  catch (L4::Runtime_error &e)
+    {
+      fprintf(stderr, "Runtime error: %s.\n", e.str());
+      return 1;
+    }
+  return 0;
+}
@@ -0,0 +1,105 @@
+/**
+ * \file
+ * \brief Copy-on-write data space clone example.
+ *
+ * Populates every 16th page of a 64 MiB data space, clones it, and checks
+ * that the clone sees the contents while writes to either data space stay
+ * private. The time to clone is compared with copying the data space into
+ * a fresh one with copy_in().
+ */
+/*
+ * This file is distributed under the terms of the GNU General Public
+ * License 2. Please see the COPYING-GPL-2 file for details.
+ */
+#include <l4/re/env>
+#include <l4/re/env.h>
+#include <l4/re/rm>
+#include <l4/re/dataspace>
+#include <l4/re/mem_alloc>
+#include <l4/re/util/cap_alloc>
+#include <l4/sys/kip.h>
+
+#include <stdio.h>
+
+enum
+{
+  Size   = 64 << 20,
+  Stride = 16 * L4_PAGESIZE,
+};
+
+static l4_cpu_time_t now()
+{ return l4_kip_clock(l4re_kip()); }
+
+static char *attach(L4::Cap<L4Re::Dataspace> ds)
+{
+  l4_addr_t a = 0;
+  if (L4Re::Env::env()->rm()->attach(&a, Size, L4Re::Rm::Search_addr, ds))
+    return 0;
+  return (char *)a;
+}
+
+int main()
+{
+  L4Re::Env const *env = L4Re::Env::env();
+  L4::Cap<L4Re::Dataspace> src = L4Re::Util::cap_alloc.alloc<L4Re::Dataspace>();
+  L4::Cap<L4Re::Dataspace> cl = L4Re::Util::cap_alloc.alloc<L4Re::Dataspace>();
+  L4::Cap<L4Re::Dataspace> cp = L4Re::Util::cap_alloc.alloc<L4Re::Dataspace>();
+
+  if (!src.is_valid() || !cl.is_valid() || !cp.is_valid()
+      || env->mem_alloc()->alloc(Size, src))
+    {
+      printf("cannot allocate memory\n");
+      return 1;
+    }
+
+  char *s = attach(src);
+  if (!s)
+    {
+      printf("cannot attach source\n");
+      return 1;
+    }
+
+  for (unsigned long o = 0; o < Size; o += Stride)
+    s[o] = (char)(o / Stride);
+
+  l4_cpu_time_t t = now();
+  if (env->mem_alloc()->clone(src, cl))
+    {
+      printf("clone failed\n");
+      return 1;
+    }
+  t = now() - t;
+  printf("clone:   %llu us\n", (unsigned long long)t);
+
+  t = now();
+  if (env->mem_alloc()->alloc(Size, cp) || cp->copy_in(0, src, 0, Size))
+    {
+      printf("copy failed\n");
+      return 1;
+    }
+  t = now() - t;
+  printf("copy_in: %llu us\n", (unsigned long long)t);
+
+  char *c = attach(cl);
+  if (!c)
+    {
+      printf("cannot attach clone\n");
+      return 1;
+    }
+
+  unsigned long bad = 0;
+  for (unsigned long o = 0; o < Size; o += Stride)
+    {
+      if (c[o] != (char)(o / Stride))
+        ++bad;
+      c[o] = 1;
+      s[o + 1] = 2;
+    }
+
+  for (unsigned long o = 0; o < Size; o += Stride)
+    if (s[o] != (char)(o / Stride) || c[o + 1])
+      ++bad;
+
+  printf("%s: %lu mismatches\n", bad ? "FAILED" : "OK", bad);
+  return bad != 0;
+}
@@ -0,0 +1,140 @@
+/**
+ * \file
+ * \brief Isolation test for the reservation-based EDF scheduling class.
+ *
+ * Three threads share CPU0. A guaranteed thread holds a reservation of
+ * 4ms per 10ms and needs 3ms of CPU time every period. An overloaded
+ * thread holds 3ms per 10ms but never stops computing. A fixed priority
+ * thread computes in the background. The guaranteed thread must not miss
+ * a single period, the overloaded one must not get more than its share,
+ * and the background thread gets the rest.
+ *
+ * Needs a kernel with the combined fixed priority and EDF scheduler
+ * (CONFIG_SCHED_FP_EDF).
+ */
+/*
+ * This file is distributed under the terms of the GNU General Public
+ * License 2. Please see the COPYING-GPL-2 file for details.
+ */
+#include <l4/re/env>
+#include <l4/sys/kip.h>
+#include <l4/sys/scheduler>
+#include <l4/sys/thread>
+#include <l4/util/util.h>
+
+#include <pthread-l4.h>
+#include <stdio.h>
+
+enum
+{
+  Period     = 10000, // all times in µs
+  Guaranteed = 4000,
+  Work       = 3000,
+  Overloaded = 3000,
+  Periods    = 300,
+};
+
+static l4_kernel_info_t *kip;
+static unsigned volatile done_periods, misses;
+
+static l4_kernel_clock_t cpu_time(L4::Cap<L4::Thread> t)
+{
+  if (l4_error(t->stats_time()))
+    return 0;
+  return *reinterpret_cast<l4_kernel_clock_t *>(l4_utcb_mr()->mr);
+}
+
+static L4::Cap<L4::Thread> self()
+{ return L4::Cap<L4::Thread>(pthread_getl4cap(pthread_self())); }
+
+static void *guaranteed(void *)
+{
+  L4::Cap<L4::Thread> me = self();
+  l4_kernel_clock_t start = l4_kip_clock(kip);
+
+  for (unsigned p = 0; p < Periods; ++p)
+    {
+      l4_kernel_clock_t release = start + (l4_kernel_clock_t)p * Period;
+      l4_kernel_clock_t end = cpu_time(me) + Work;
+      while (cpu_time(me) < end)
+        ;
+
+      if (l4_kip_clock(kip) > release + Period)
+        ++misses;
+      done_periods = p + 1;
+
+      l4_kernel_clock_t now = l4_kip_clock(kip);
+      if (now < release + Period)
+        l4_usleep(release + Period - now);
+    }
+
+  return 0;
+}
+
+static void *spin(void *)
+{
+  for (;;)
+    ;
+  return 0;
+}
+
+static int run(L4::Cap<L4::Scheduler> s, pthread_t t, unsigned budget)
+{
+  L4::Cap<L4::Thread> c(pthread_getl4cap(t));
+  if (budget)
+    {
+      l4_sched_param_edf_t sp = l4_sched_param_edf(budget, Period);
+      sp.affinity = l4_sched_cpu_set(0, 0);
+      return l4_error(s->run_thread(c, sp));
+    }
+
+  l4_sched_param_t sp = l4_sched_param(2);
+  sp.affinity = l4_sched_cpu_set(0, 0);
+  return l4_error(s->run_thread(c, sp));
+}
+
+int main()
+{
+  kip = l4re_kip();
+  L4::Cap<L4::Scheduler> sched = L4Re::Env::env()->scheduler();
+
+  // the main thread only sleeps and reports, keep it above the others
+  l4_sched_param_t sp = l4_sched_param(10);
+  sp.affinity = l4_sched_cpu_set(0, 0);
+  sched->run_thread(L4Re::Env::env()->main_thread(), sp);
+
+  pthread_t g, o, b;
+  if (pthread_create(&o, NULL, spin, NULL)
+      || pthread_create(&b, NULL, spin, NULL)
+      || pthread_create(&g, NULL, guaranteed, NULL))
+    return 1;
+
+  if (run(sched, o, Overloaded) || run(sched, b, 0)
+      || run(sched, g, Guaranteed))
+    {
+      printf("Cannot set scheduling parameters\n");
+      return 1;
+    }
+
+  l4_kernel_clock_t t0 = l4_kip_clock(kip);
+  l4_kernel_clock_t o0 = cpu_time(L4::Cap<L4::Thread>(pthread_getl4cap(o)));
+  l4_kernel_clock_t b0 = cpu_time(L4::Cap<L4::Thread>(pthread_getl4cap(b)));
+
+  pthread_join(g, NULL);
+
+  l4_kernel_clock_t t = l4_kip_clock(kip) - t0;
+  unsigned o_share = (cpu_time(L4::Cap<L4::Thread>(pthread_getl4cap(o))) - o0)
+                     * 100 / t;
+  unsigned b_share = (cpu_time(L4::Cap<L4::Thread>(pthread_getl4cap(b))) - b0)
+                     * 100 / t;
+
+  printf("guaranteed: %u periods, %u deadline misses\n", done_periods, misses);
+  printf("overloaded: %u%% CPU (reserved %u%%)\n",
+         o_share, Overloaded * 100 / Period);
+  printf("background: %u%% CPU\n", b_share);
+
+  // allow one percent for the timer resolution
+  bool ok = !misses && o_share <= Overloaded * 100 / Period + 1 && b_share;
+  printf("%s\n", ok ? "PASSED" : "FAILED");
+  return !ok;
+}
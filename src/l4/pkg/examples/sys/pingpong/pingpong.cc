@@ -0,0 +1,114 @@
+/**
+ * \file
+ * \brief IPC round-trip benchmark.
+ *
+ * A client thread calls a server thread on the same CPU that answers with
+ * reply-and-wait, both exchanging a few untyped words. The first run uses
+ * infinite timeouts, which the kernel handles in its IPC fastpath. The
+ * second run gives every receive a finite timeout and so forces both
+ * directions through the generic IPC path.
+ */
+/*
+ * This file is distributed under the terms of the GNU General Public
+ * License 2. Please see the COPYING-GPL-2 file for details.
+ */
+#include <l4/re/env>
+#include <l4/sys/ipc.h>
+#include <l4/sys/scheduler>
+#include <l4/sys/utcb.h>
+
+#include <pthread-l4.h>
+#include <stdio.h>
+
+#if !defined(__mips__)
+#include <l4/util/rdtsc.h>
+#endif
+
+enum
+{
+  Words  = 2,
+  Rounds = 100000,
+  Warmup = 1000,
+};
+
+enum Mode { Fast, Slow };
+
+static l4_timeout_t slow_timeout()
+{
+  return l4_timeout(L4_IPC_TIMEOUT_NEVER, l4_timeout_rel(1023, 31));
+}
+
+static inline l4_uint32_t cycles()
+{
+#if defined(__mips__)
+  l4_uint32_t c;
+  asm volatile (".set push; .set mips32r2; rdhwr %0, $2; .set pop" : "=r" (c));
+  return c;
+#else
+  return l4_rdtsc_32();
+#endif
+}
+
+static void *server(void *)
+{
+  l4_utcb_t *u = l4_utcb();
+  l4_umword_t label;
+  l4_msgtag_t tag = l4_ipc_wait(u, &label, L4_IPC_NEVER);
+
+  for (;;)
+    {
+      if (l4_ipc_error(tag, u))
+        {
+          tag = l4_ipc_wait(u, &label, L4_IPC_NEVER);
+          continue;
+        }
+
+      l4_timeout_t to = l4_utcb_mr_u(u)->mr[0] == Slow
+                        ? slow_timeout() : L4_IPC_NEVER;
+      tag = l4_ipc_reply_and_wait(u, l4_msgtag(0, Words, 0, 0), &label, to);
+    }
+  return 0;
+}
+
+static void bench(l4_cap_idx_t srv, Mode mode, char const *name)
+{
+  l4_utcb_t *u = l4_utcb();
+  l4_timeout_t to = mode == Slow ? slow_timeout() : L4_IPC_NEVER;
+  l4_uint32_t start = 0;
+  unsigned errors = 0;
+
+  for (unsigned r = 0; r < Warmup + Rounds; ++r)
+    {
+      if (r == Warmup)
+        start = cycles();
+
+      l4_utcb_mr_u(u)->mr[0] = mode;
+      l4_utcb_mr_u(u)->mr[1] = r;
+      if (l4_ipc_error(l4_ipc_call(srv, u, l4_msgtag(0, Words, 0, 0), to), u))
+        ++errors;
+    }
+  l4_uint32_t t = cycles() - start;
+
+  printf("%-10s %6u cycles per round trip (%u rounds, %u errors)\n",
+         name, t / Rounds, (unsigned)Rounds, errors);
+}
+
+int main()
+{
+  pthread_t t;
+  if (pthread_create(&t, NULL, server, NULL))
+    return 1;
+
+  // keep both threads on the boot CPU, cross-CPU IPC is never fast
+  l4_sched_param_t sp = l4_sched_param(2);
+  sp.affinity = l4_sched_cpu_set(0, 0);
+  L4::Cap<L4::Scheduler> sched = L4Re::Env::env()->scheduler();
+  if (l4_error(sched->run_thread(L4::Cap<L4::Thread>(pthread_getl4cap(t)), sp))
+      || l4_error(sched->run_thread(L4Re::Env::env()->main_thread(), sp)))
+    printf("Cannot move threads to CPU0\n");
+
+  l4_cap_idx_t srv = pthread_getl4cap(t);
+  bench(srv, Fast, "fastpath:");
+  bench(srv, Slow, "slowpath:");
+  return 0;
+}
@@ -0,0 +1,106 @@
+/**
+ * \file
+ * \brief Region manager attach/detach benchmark.
+ *
+ * Attaches a one-page dataspace 100000 times with Search_addr, punches
+ * holes into the resulting mapping by detaching every other region, fills
+ * them with aligned two-page regions that do not fit the holes, and
+ * finally detaches everything. The time per operation is reported for
+ * every 10000 operations, so it shows whether attach latency grows with
+ * the number of regions.
+ */
+/*
+ * This file is distributed under the terms of the GNU General Public
+ * License 2. Please see the COPYING-GPL-2 file for details.
+ */
+#include <l4/re/env>
+#include <l4/re/env.h>
+#include <l4/re/rm>
+#include <l4/re/dataspace>
+#include <l4/re/mem_alloc>
+#include <l4/re/util/cap_alloc>
+#include <l4/sys/kip.h>
+
+#include <stdio.h>
+
+enum
+{
+  Regions = 100000,
+  Batch   = 10000,
+};
+
+static l4_addr_t addr[Regions];
+
+static l4_cpu_time_t now()
+{ return l4_kip_clock(l4re_kip()); }
+
+static void report(char const *what, unsigned long first, l4_cpu_time_t t)
+{
+  printf("%-8s %6lu-%6lu: %6llu ns per call\n", what, first,
+         first + Batch - 1, (unsigned long long)t * 1000 / Batch);
+}
+
+int main()
+{
+  L4Re::Env const *env = L4Re::Env::env();
+  L4::Cap<L4Re::Dataspace> ds = L4Re::Util::cap_alloc.alloc<L4Re::Dataspace>();
+
+  if (!ds.is_valid() || env->mem_alloc()->alloc(2 * L4_PAGESIZE, ds))
+    {
+      printf("cannot allocate memory\n");
+      return 1;
+    }
+
+  l4_cpu_time_t start = now();
+  for (unsigned long i = 0; i < Regions; ++i)
+    {
+      if (env->rm()->attach(&addr[i], L4_PAGESIZE, L4Re::Rm::Search_addr, ds))
+        {
+          printf("attach %lu failed\n", i);
+          return 1;
+        }
+
+      if ((i + 1) % Batch == 0)
+        {
+          report("attach", i + 1 - Batch, now() - start);
+          start = now();
+        }
+    }
+
+  // leave one-page holes that the two-page regions below cannot use
+  for (unsigned long i = 0; i < Regions; i += 2)
+    env->rm()->detach(addr[i], 0);
+
+  start = now();
+  for (unsigned long i = 0; i < Regions; i += 2)
+    {
+      if (env->rm()->attach(&addr[i], 2 * L4_PAGESIZE, L4Re::Rm::Search_addr,
+                            ds, 0, L4_PAGESHIFT + 1))
+        {
+          printf("aligned attach %lu failed\n", i);
+          return 1;
+        }
+
+      if ((i + 2) % Batch == 0)
+        {
+          report("aligned", i + 2 - Batch, (now() - start) * 2);
+          start = now();
+        }
+    }
+
+  start = now();
+  for (unsigned long i = 0; i < Regions; ++i)
+    {
+      env->rm()->detach(addr[i], 0);
+
+      if ((i + 1) % Batch == 0)
+        {
+          report("detach", i + 1 - Batch, now() - start);
+          start = now();
+        }
+    }
+
+  env->mem_alloc()->free(ds);
+  L4Re::Util::cap_alloc.free(ds, L4Re::This_task);
+  return 0;
+}
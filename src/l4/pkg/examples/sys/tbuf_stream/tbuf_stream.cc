@@ -0,0 +1,92 @@
+/**
+ * \file
+ * \brief Drain the per-CPU kernel trace streams.
+ *
+ * Switches on IPC logging, generates IPC load and drains the trace streams
+ * once a second, reporting the number of entries read and lost. With a
+ * file name argument, the raw entries are written to that file instead.
+ *
+ * Needs a kernel with the kernel debugger and the trace buffer.
+ */
+/*
+ * This file is distributed under the terms of the GNU General Public
+ * License 2. Please see the COPYING-GPL-2 file for details.
+ */
+#include <l4/re/env.h>
+#include <l4/sys/debugger.h>
+#include <l4/sys/ipc.h>
+#include <l4/sys/kip.h>
+#include <l4/tbuf/tbuf.h>
+
+#include <stdio.h>
+
+enum { Rounds = 10, Burst = 10000 };
+
+static char buf[64 * 128];
+
+static unsigned long read_all(l4tbuf_stream_t *s, unsigned long *lost)
+{
+  l4tbuf_stream_status_t const *st = l4tbuf_stream_status(s);
+  unsigned long const max = sizeof(buf) / st->entry_size;
+  unsigned long total = 0, n;
+
+  for (unsigned c = 0; c < st->cpus; ++c)
+    while ((n = l4tbuf_stream_read(s, c, buf, max, lost)))
+      total += n;
+
+  return total;
+}
+
+int main(int argc, char **argv)
+{
+  l4tbuf_stream_t *s = l4tbuf_stream_open();
+  if (!s)
+    {
+      printf("Kernel does not support trace streams\n");
+      return 1;
+    }
+
+  FILE *f = 0;
+  if (argc > 1 && !(f = fopen(argv[1], "w")))
+    {
+      printf("Cannot open %s\n", argv[1]);
+      return 1;
+    }
+
+  l4_debugger_switch_log(L4RE_THIS_TASK_CAP, "ipc", L4_DEBUGGER_SWITCH_LOG_ON);
+
+  l4_kernel_info_t *kip = l4re_kip();
+  for (unsigned r = 0; r < Rounds; ++r)
+    {
+      l4_cpu_time_t end = l4_kip_clock(kip) + 1000000;
+      unsigned long entries = 0, lost = 0;
+      while (l4_kip_clock(kip) < end)
+        {
+          // each open wait times out at once and is logged
+          l4_umword_t label;
+          for (unsigned i = 0; i < Burst; ++i)
+            l4_ipc_wait(l4_utcb(), &label, L4_IPC_BOTH_TIMEOUT_0);
+
+          if (f)
+            {
+              long n = l4tbuf_stream_drain(s, f, &lost);
+              if (n < 0)
+                {
+                  printf("Write error\n");
+                  return 1;
+                }
+              entries += n;
+            }
+          else
+            entries += read_all(s, &lost);
+        }
+
+      printf("%lu entries, %lu lost\n", entries, lost);
+    }
+
+  l4_debugger_switch_log(L4RE_THIS_TASK_CAP, "ipc", L4_DEBUGGER_SWITCH_LOG_OFF);
+  l4tbuf_stream_close(s);
+  if (f)
+    fclose(f);
+  return 0;
+}
@@ -0,0 +1,140 @@
+/**
+ * \file
+ * \brief Unmap latency benchmark.
+ *
+ * Threads of this task on all online CPUs touch a buffer so that every
+ * CPU holds TLB entries of the task. The main thread then repeatedly
+ * faults in a page and unmaps it again, once while the other threads
+ * sleep and once while they keep running on their CPUs. In the first
+ * case the kernel may postpone the remote TLB flushes until a CPU
+ * switches back to the task, in the second one it has to send IPIs.
+ */
+/*
+ * This file is distributed under the terms of the GNU General Public
+ * License 2. Please see the COPYING-GPL-2 file for details.
+ */
+#include <l4/re/env>
+#include <l4/re/env.h>
+#include <l4/re/rm>
+#include <l4/re/dataspace>
+#include <l4/re/util/cap_alloc>
+#include <l4/sys/kip.h>
+#include <l4/sys/scheduler>
+
+#include <pthread-l4.h>
+#include <unistd.h>
+#include <stdio.h>
+
+enum
+{
+  Max_threads = 16,
+  Pages       = 64,
+  Rounds      = 20000,
+};
+
+enum Phase { Touch, Sleep, Spin, Done };
+
+static char *buf;
+static Phase volatile phase = Touch;
+static unsigned volatile touched;
+
+static void touch_pages()
+{
+  for (unsigned i = 0; i < Pages; ++i)
+    (void)*(char volatile *)(buf + i * L4_PAGESIZE);
+}
+
+static void *worker(void *)
+{
+  touch_pages();
+  __sync_fetch_and_add(&touched, 1);
+
+  while (phase != Done)
+    {
+      if (phase == Spin)
+        touch_pages();
+      else
+        usleep(10000);
+    }
+  return 0;
+}
+
+static int start_workers()
+{
+  l4_umword_t cpu_nrs;
+  l4_sched_cpu_set_t cs = l4_sched_cpu_set(0, 0);
+  L4::Cap<L4::Scheduler> sched = L4Re::Env::env()->scheduler();
+
+  if (l4_error(sched->info(&cpu_nrs, &cs)) < 0)
+    return -1;
+
+  unsigned n = 0;
+  for (unsigned c = 1; c < cpu_nrs && c < L4_MWORD_BITS && n < Max_threads; ++c)
+    {
+      if (!sched->is_online(c))
+        continue;
+
+      pthread_t t;
+      if (pthread_create(&t, NULL, worker, NULL))
+        return -1;
+
+      l4_sched_param_t sp = l4_sched_param(2);
+      sp.affinity = l4_sched_cpu_set(c, 0);
+      if (l4_error(sched->run_thread(L4::Cap<L4::Thread>(pthread_getl4cap(t)), sp)))
+        printf("Cannot move worker to CPU%u\n", c);
+      ++n;
+    }
+
+  while (touched < n)
+    usleep(1000);
+
+  return n;
+}
+
+static void bench(char const *name)
+{
+  L4::Cap<L4::Task> task = L4Re::Env::env()->task();
+  l4_kernel_info_t *kip = l4re_kip();
+
+  l4_cpu_time_t start = l4_kip_clock(kip);
+  for (unsigned r = 0; r < Rounds; ++r)
+    {
+      char *p = buf + (r % Pages) * L4_PAGESIZE;
+      *(char volatile *)p = r;
+      task->unmap(l4_fpage((l4_addr_t)p, L4_PAGESHIFT, L4_FPAGE_RWX),
+                  L4_FP_ALL_SPACES);
+    }
+  l4_cpu_time_t t = l4_kip_clock(kip) - start;
+
+  printf("%-24s %6llu ns per fault+unmap (%u rounds)\n", name,
+         (unsigned long long)t * 1000 / Rounds, (unsigned)Rounds);
+}
+
+int main()
+{
+  L4::Cap<L4Re::Dataspace> ds = L4Re::Util::cap_alloc.alloc<L4Re::Dataspace>();
+  if (!ds.is_valid())
+    return 1;
+
+  if (L4Re::Env::env()->mem_alloc()->alloc(Pages * L4_PAGESIZE, ds))
+    return 1;
+
+  if (L4Re::Env::env()->rm()->attach(&buf, Pages * L4_PAGESIZE,
+                                     L4Re::Rm::Search_addr, ds))
+    return 1;
+
+  int n = start_workers();
+  if (n < 0)
+    return 1;
+
+  printf("%d worker thread(s) on remote CPUs\n", n);
+
+  phase = Sleep;
+  bench("remote CPUs idle:");
+
+  phase = Spin;
+  bench("remote CPUs in task:");
+
+  phase = Done;
+  return 0;
+}
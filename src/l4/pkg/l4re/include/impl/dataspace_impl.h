@@ -53,6 +53,25 @@ Dataspace::__map(unsigned long offset, unsigned char *size, unsigned long flags,
   return err;
 }
 
+long
+Dataspace::__map_region(l4_addr_t offset, unsigned char order,
+                        unsigned long flags, l4_addr_t local_addr,
+                        unsigned long *mapped) const throw()
+{
+  L4::Ipc::Iostream io(l4_utcb());
+  io << L4::Opcode(Dataspace_::Map_region) << offset << l4_umword_t(order)
+     << flags;
+  io << L4::Ipc::Rcv_fpage::mem(local_addr, order, 0);
+  long err = l4_error(io.call(cap(), L4Re::Protocol::Dataspace));
+  if (err < 0)
+    return err;
+
+  l4_umword_t m;
+  io >> m;
+  *mapped = m;
+  return err;
+}
+
 long
 Dataspace::map_region(l4_addr_t offset, unsigned long flags,
                       l4_addr_t min_addr, l4_addr_t max_addr) const throw()
@@ -63,6 +82,28 @@ Dataspace::map_region(l4_addr_t offset, unsigned long flags,
 
   long err = 0;
 
+  while (min_addr < max_addr)
+    {
+      unsigned long mapped;
+      order = l4_fpage_max_order(L4_LOG2_PAGESIZE, min_addr, min_addr,
+                                 max_addr, min_addr);
+      err = __map_region(offset, order, flags, min_addr, &mapped);
+      if (err == -L4_ENOSYS)
+        break;
+
+      if (L4_UNLIKELY(err < 0))
+        return err;
+
+      if (L4_UNLIKELY(!mapped || mapped > (1UL << order)))
+        return -L4_EINVAL;
+
+      min_addr += mapped;
+      offset   += mapped;
+    }
+
+  // the server maps one flex page per request
+  order = L4_LOG2_PAGESIZE;
+
   while (min_addr < max_addr)
     {
       unsigned char order_mapped;
@@ -54,4 +54,13 @@ Mem_alloc::free(L4::Cap<Dataspace> mem) const throw()
   return l4_error(io.call(cap(), L4Re::Protocol::Mem_alloc));
 }
 
+long
+Mem_alloc::clone(L4::Cap<Dataspace> src, L4::Cap<Dataspace> mem) const throw()
+{
+  L4::Ipc::Iostream io(l4_utcb());
+  io << L4::Opcode(Mem_alloc_::Clone) << src;
+  io << L4::Ipc::Small_buf(mem.cap());
+  return l4_error(io.call(cap(), L4Re::Protocol::Mem_alloc));
+}
+
 };
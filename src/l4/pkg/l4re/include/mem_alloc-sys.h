@@ -31,6 +31,6 @@ namespace L4Re
      * \ingroup api_l4re_protocols
      * \internal
      */
-    enum Opcodes { Alloc, Free };
+    enum Opcodes { Alloc, Free, Clone };
   };
 };
@@ -18,6 +18,7 @@
 
 #include <l4/cxx/iostream>
 #include <l4/cxx/l4iostream>
+#include <l4/cxx/minmax>
 
 #include <l4/re/util/region_mapping_svr>
 
@@ -70,7 +71,8 @@ Region_map::init()
 
 int
 Region_ops::map(Region_handler const *h, l4_addr_t local_adr,
-                Region const &r, bool writable, l4_umword_t *result)
+                Region const &r, bool writable, unsigned char around,
+                l4_umword_t *result)
 {
   *result = 0;
   if ((h->flags() & Rm::Reserved) || !h->memory().is_valid())
@@ -88,7 +90,24 @@ Region_ops::map(Region_handler const *h, l4_addr_t local_adr,
     {
       l4_addr_t offset = local_adr - r.start() + h->offset();
       L4::Cap<L4Re::Dataspace> ds = L4::cap_cast<L4Re::Dataspace>(h->memory());
-      return ds->map(offset, writable, local_adr, r.start(), r.end());
+      unsigned long flags = writable ? Dataspace::Map_rw : Dataspace::Map_ro;
+
+      if (around > L4_PAGESHIFT)
+        {
+          // map the fault-around window with as few requests as possible
+          l4_addr_t start = cxx::max(l4_trunc_size(local_adr, around),
+                                     r.start());
+          l4_addr_t end = cxx::min(l4_trunc_size(local_adr, around)
+                                   + (1UL << around) - 1, r.end());
+          int err = ds->map_region(offset - (local_adr - start), flags,
+                                   start, end + 1);
+          // the window may reach beyond the end of the dataspace, the
+          // faulting page alone must not fail for that
+          if (err >= 0)
+            return err;
+        }
+
+      return ds->map(offset, flags, local_adr, r.start(), r.end());
     }
 }
 
@@ -38,7 +38,7 @@ public:
   typedef l4_umword_t Map_result;
   static int map(Region_handler const *h, l4_addr_t addr,
                  L4Re::Util::Region const &r, bool writable,
-                 l4_umword_t *result);
+                 unsigned char around, l4_umword_t *result);
 
   static void unmap(Region_handler const *h, l4_addr_t vaddr,
                     l4_addr_t offs, unsigned long size);
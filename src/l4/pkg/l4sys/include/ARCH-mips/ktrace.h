@@ -55,6 +55,34 @@
 				       **  \ingroup api_calls_fiasco
 				       **/
 
+/**
+ * Latency histograms in the trace buffer status, filled by kernels built
+ * with CONFIG_JDB_LATENCY_HIST.
+ * \ingroup api_calls_fiasco
+ *
+ * Values are cycle-counter ticks (CP0 Count). Bucket 0 counts samples
+ * below 1 << L4_LAT_HIST_SHIFT ticks, bucket n > 0 samples in
+ * [1 << (n + L4_LAT_HIST_SHIFT - 1), 1 << (n + L4_LAT_HIST_SHIFT)), the
+ * last bucket also all longer ones. CPU n < L4_LAT_HIST_CPUS uses slot n,
+ * the histograms of further CPUs are in the trace streaming area, see
+ * l4tbuf_stream_status_t.
+ */
+enum L4_lat_hist
+{
+  L4_LAT_HIST_SPIN_WAIT      = 0, /**< Spin-lock acquisition */
+  L4_LAT_HIST_SPIN_HOLD      = 1, /**< Spin lock held (outermost lock) */
+  L4_LAT_HIST_LOCK_WAIT      = 2, /**< Switch-lock acquisition */
+  L4_LAT_HIST_LOCK_HOLD      = 3, /**< Switch lock held */
+  L4_LAT_HIST_IPC_CALL       = 4, /**< IPC call, send to reply */
+  L4_LAT_HIST_PAGE_FAULT     = 5, /**< Page-fault handling */
+  L4_LAT_HIST_CONTEXT_SWITCH = 6, /**< Context switch */
+  L4_LAT_HIST_MAX,
+
+  L4_LAT_HIST_BUCKETS        = 24,
+  L4_LAT_HIST_SHIFT          = 4,
+  L4_LAT_HIST_CPUS           = 4,
+};
+
 /**
  * Trace buffer status.
  * \ingroup api_calls_fiasco
@@ -66,36 +94,64 @@ typedef struct
   /// Size of trace buffer 0
   l4_umword_t size0;
   /// Version number of trace buffer 0 (incremented if tb0 overruns)
-  l4_umword_t version0;
+  l4_uint64_t version0;
   /// Address of trace buffer 1 (there is no gap between tb0 and tb1)
   l4_umword_t tracebuffer1;
   /// Size of trace buffer 1 (same as tb0)
   l4_umword_t size1;
   /// Version number of trace buffer 1 (incremented if tb1 overruns)
-  l4_umword_t version1;
+  l4_uint64_t version1;
+  /// Kernel address of the most recent trace buffer entry
+  l4_umword_t current;
   /// Available LOG events
-  l4_umword_t logevents[LOG_EVENT_MAX_EVENTS];
+  l4_uint32_t logevents[LOG_EVENT_MAX_EVENTS];
 
   /// Scaler used for translation of CPU cycles to nano seconds
-  l4_umword_t scaler_tsc_to_ns;
+  l4_uint32_t scaler_tsc_to_ns;
   /// Scaler used for translation of CPU cycles to micro seconds
-  l4_umword_t scaler_tsc_to_us;
+  l4_uint32_t scaler_tsc_to_us;
   /// Scaler used for translation of nano seconds to CPU cycles
-  l4_umword_t scaler_ns_to_tsc;
+  l4_uint32_t scaler_ns_to_tsc;
 
   /// Number of context switches (intra AS or inter AS)
-  l4_umword_t cnt_context_switch;
+  l4_uint32_t cnt_context_switch;
   /// Number of inter AS context switches
-  l4_umword_t cnt_addr_space_switch;
+  l4_uint32_t cnt_addr_space_switch;
   /// How often was the IPC shortcut not taken
-  l4_umword_t cnt_shortcut_failed;
+  l4_uint32_t cnt_shortcut_failed;
   /// How often was the IPC shortcut taken
-  l4_umword_t cnt_shortcut_success;
+  l4_uint32_t cnt_shortcut_success;
   /// Number of hardware interrupts (without kernel scheduling interrupt)
-  l4_umword_t cnt_irq;
+  l4_uint32_t cnt_irq;
   /// Number of long IPCs
-  l4_umword_t cnt_ipc_long;
+  l4_uint32_t cnt_ipc_long;
+  /// Number of page faults
+  l4_uint32_t cnt_page_fault;
+  /// Number of IO faults
+  l4_uint32_t cnt_io_fault;
+  /// Number of created tasks
+  l4_uint32_t cnt_task_create;
+  /// Number of scheduler invocations
+  l4_uint32_t cnt_schedule;
+  /// Number of TLB flushes caused by IO bitmap changes
+  l4_uint32_t cnt_iobmap_tlb_flush;
+  /// Number of exception IPCs
+  l4_uint32_t cnt_exc_ipc;
+  /// Number of cross-CPU requests queued without an IPI
+  l4_uint32_t cnt_drq_ipi_saved;
+  /// Number of cross-CPU request batches handled
+  l4_uint32_t cnt_drq_batches;
+  /// Number of cross-CPU requests handled in batches
+  l4_uint32_t cnt_drq_batch_items;
+  /// Number of FPU traps switching in the FPU state
+  l4_uint32_t cnt_fpu_trap;
+  /// Number of FPU state switches done eagerly, without an FPU trap
+  l4_uint32_t cnt_fpu_eager;
+  /// Number of threads switched back to lazy FPU switching
+  l4_uint32_t cnt_fpu_eager_drop;
 
+  /// Latency histograms, see #L4_lat_hist
+  l4_uint32_t lat_hist[L4_LAT_HIST_CPUS][L4_LAT_HIST_MAX][L4_LAT_HIST_BUCKETS];
 } l4_tracebuffer_status_t;
 
 /**
@@ -184,8 +240,7 @@ fiasco_tbuf_get_status(void)
 L4_INLINE l4_addr_t
 fiasco_tbuf_get_status_phys(void)
 {
-  enter_kdebug("fiasco_tbuf_get_status_phys not there");
-  return ~0UL;
+  return __kdebug_param(29, 5, 0);
 }
 
 L4_INLINE l4_umword_t
@@ -0,0 +1,284 @@
+/**
+ * \file
+ * \brief Submission ring for batched kernel object invocations.
+ * \ingroup l4_api
+ */
+/*
+ * This file is part of TUD:OS and distributed under the terms of the
+ * GNU General Public License 2.
+ * Please see the COPYING-GPL-2 file for details.
+ *
+ * As a special exception, you may use this file as part of a free software
+ * library without restriction.  Specifically, if other files instantiate
+ * templates or use macros or inline functions from this file, or you compile
+ * this file and link it with other files to produce an executable, this
+ * file does not by itself cause the resulting executable to be covered by
+ * the GNU General Public License.  This exception does not however
+ * invalidate any other reasons why the executable file might be covered by
+ * the GNU General Public License.
+ */
+#pragma once
+
+#include <l4/sys/consts.h>
+#include <l4/sys/irq.h>
+#include <l4/sys/task.h>
+#include <l4/sys/thread.h>
+#include <l4/sys/types.h>
+
+/**
+ * \defgroup l4_batch_api Submission ring
+ * \ingroup l4_thread_api
+ * \brief Batched invocation of kernel objects.
+ *
+ * <c>\#include <l4/sys/batch.h></c>
+ *
+ * A thread can queue invocations of task, IRQ and thread objects in a ring
+ * in kernel-user memory and let the kernel execute all of them with a
+ * single l4_thread_batch_submit(). The kernel writes the result of every
+ * invocation back into its entry, where the thread collects it with
+ * l4_batch_pop().
+ *
+ * Supported are all task operations, IRQ operations without a receive
+ * phase (e.g. l4_irq_unmask()), and thread ex_regs. Other invocations
+ * fail with -L4_EBADPROTO.
+ *
+ * An entry may block or switch to another thread like the invocation it
+ * stands for: ex_regs of a thread on another CPU waits for that CPU, and
+ * triggering an IRQ may run the woken thread first. The remaining entries
+ * are executed when the submitting thread runs again.
+ */
+
+enum
+{
+  L4_BATCH_MRS         = 6,    /**< Message words per entry */
+  L4_BATCH_MAX_ENTRIES = 4096, /**< Maximum number of ring entries */
+};
+
+/**
+ * \brief Entry of the submission ring.
+ * \ingroup l4_batch_api
+ *
+ * After execution, \a tag holds the result tag and \a mr the reply words,
+ * or the IPC error code in mr[0] if the result tag has the error flag set.
+ */
+typedef struct l4_batch_entry_t
+{
+  l4_umword_t cap;              /**< Capability selector | L4_SYSF_CALL or L4_SYSF_SEND */
+  l4_umword_t tag;              /**< Message tag, the result tag on completion */
+  l4_umword_t mr[L4_BATCH_MRS]; /**< Message words, reply words on completion */
+} l4_batch_entry_t;
+
+/**
+ * \brief Head of the submission ring, followed by the entries.
+ * \ingroup l4_batch_api
+ *
+ * All indexes run freely and wrap around the number of entries.
+ */
+typedef struct l4_batch_ring_t
+{
+  l4_umword_t head;  /**< Next entry to execute, written by the kernel */
+  l4_umword_t tail;  /**< Next free entry */
+  l4_umword_t done;  /**< Next result to collect */
+  l4_umword_t _pad;
+} l4_batch_ring_t;
+
+/**
+ * \brief Size of a ring with the given number of entries, in bytes.
+ * \ingroup l4_batch_api
+ */
+L4_INLINE unsigned long
+l4_batch_ring_size(unsigned entries) L4_NOTHROW;
+
+/**
+ * \brief Reset a ring to the empty state.
+ * \ingroup l4_batch_api
+ */
+L4_INLINE void
+l4_batch_init(l4_batch_ring_t *ring) L4_NOTHROW;
+
+/**
+ * \brief Queue an invocation.
+ * \ingroup l4_batch_api
+ *
+ * \param ring    The ring.
+ * \param entries Number of entries of the ring.
+ * \param cap     Capability selector of the object to invoke.
+ * \param op      L4_SYSF_CALL to get a reply, or L4_SYSF_SEND.
+ * \param tag     Message tag, at most #L4_BATCH_MRS words including items.
+ * \return The entry to fill in the message words, or 0 if the ring is full.
+ */
+L4_INLINE l4_umword_t *
+l4_batch_push(l4_batch_ring_t *ring, unsigned entries, l4_cap_idx_t cap,
+              unsigned op, l4_msgtag_t tag) L4_NOTHROW;
+
+/**
+ * \brief Collect the next result.
+ * \ingroup l4_batch_api
+ *
+ * \return The next executed entry, or 0 if there is none. The entry stays
+ *         valid until the next l4_batch_push().
+ */
+L4_INLINE l4_batch_entry_t *
+l4_batch_pop(l4_batch_ring_t *ring, unsigned entries) L4_NOTHROW;
+
+/**
+ * \brief Result tag of an executed entry.
+ * \ingroup l4_batch_api
+ */
+L4_INLINE l4_msgtag_t
+l4_batch_result(l4_batch_entry_t const *e) L4_NOTHROW;
+
+/**
+ * \brief Queue an l4_task_map().
+ * \ingroup l4_batch_api
+ * \return 0, or -L4_ENOMEM if the ring is full.
+ */
+L4_INLINE int
+l4_batch_task_map(l4_batch_ring_t *ring, unsigned entries,
+                  l4_cap_idx_t dst_task, l4_cap_idx_t src_task,
+                  l4_fpage_t snd_fpage, l4_addr_t snd_base) L4_NOTHROW;
+
+/**
+ * \brief Queue an l4_task_unmap().
+ * \ingroup l4_batch_api
+ * \return 0, or -L4_ENOMEM if the ring is full.
+ */
+L4_INLINE int
+l4_batch_task_unmap(l4_batch_ring_t *ring, unsigned entries,
+                    l4_cap_idx_t task, l4_fpage_t fpage,
+                    l4_umword_t map_mask) L4_NOTHROW;
+
+/**
+ * \brief Queue an l4_irq_unmask().
+ * \ingroup l4_batch_api
+ * \return 0, or -L4_ENOMEM if the ring is full.
+ */
+L4_INLINE int
+l4_batch_irq_unmask(l4_batch_ring_t *ring, unsigned entries,
+                    l4_cap_idx_t irq) L4_NOTHROW;
+
+/**
+ * \brief Queue an l4_thread_ex_regs().
+ * \ingroup l4_batch_api
+ * \return 0, or -L4_ENOMEM if the ring is full.
+ */
+L4_INLINE int
+l4_batch_thread_ex_regs(l4_batch_ring_t *ring, unsigned entries,
+                        l4_cap_idx_t thread, l4_addr_t ip, l4_addr_t sp,
+                        l4_umword_t flags) L4_NOTHROW;
+
+
+/* IMPLEMENTATION -----------------------------------------------------------*/
+
+L4_INLINE l4_batch_entry_t *
+__l4_batch_entry(l4_batch_ring_t *ring, unsigned entries,
+                 l4_umword_t idx) L4_NOTHROW
+{
+  return (l4_batch_entry_t *)(ring + 1) + (idx & (entries - 1));
+}
+
+L4_INLINE unsigned long
+l4_batch_ring_size(unsigned entries) L4_NOTHROW
+{
+  return sizeof(l4_batch_ring_t) + entries * sizeof(l4_batch_entry_t);
+}
+
+L4_INLINE void
+l4_batch_init(l4_batch_ring_t *ring) L4_NOTHROW
+{
+  ring->head = ring->tail = ring->done = 0;
+}
+
+L4_INLINE l4_umword_t *
+l4_batch_push(l4_batch_ring_t *ring, unsigned entries, l4_cap_idx_t cap,
+              unsigned op, l4_msgtag_t tag) L4_NOTHROW
+{
+  l4_batch_entry_t *e;
+  if (ring->tail - ring->done >= entries)
+    return 0;
+
+  e = __l4_batch_entry(ring, entries, ring->tail++);
+  e->cap = cap | op;
+  e->tag = tag.raw;
+  return e->mr;
+}
+
+L4_INLINE l4_batch_entry_t *
+l4_batch_pop(l4_batch_ring_t *ring, unsigned entries) L4_NOTHROW
+{
+  if (ring->done == ring->head)
+    return 0;
+
+  return __l4_batch_entry(ring, entries, ring->done++);
+}
+
+L4_INLINE l4_msgtag_t
+l4_batch_result(l4_batch_entry_t const *e) L4_NOTHROW
+{
+  l4_msgtag_t t;
+  t.raw = e->tag;
+  return t;
+}
+
+L4_INLINE int
+l4_batch_task_map(l4_batch_ring_t *ring, unsigned entries,
+                  l4_cap_idx_t dst_task, l4_cap_idx_t src_task,
+                  l4_fpage_t snd_fpage, l4_addr_t snd_base) L4_NOTHROW
+{
+  l4_umword_t *mr = l4_batch_push(ring, entries, dst_task, L4_SYSF_CALL,
+                                  l4_msgtag(L4_PROTO_TASK, 3, 1, 0));
+  if (!mr)
+    return -L4_ENOMEM;
+
+  mr[0] = L4_TASK_MAP_OP;
+  mr[1] = snd_base;
+  mr[2] = snd_fpage.raw;
+  mr[3] = l4_map_obj_control(0, 0);
+  mr[4] = l4_obj_fpage(src_task, 0, L4_FPAGE_RWX).raw;
+  return 0;
+}
+
+L4_INLINE int
+l4_batch_task_unmap(l4_batch_ring_t *ring, unsigned entries,
+                    l4_cap_idx_t task, l4_fpage_t fpage,
+                    l4_umword_t map_mask) L4_NOTHROW
+{
+  l4_umword_t *mr = l4_batch_push(ring, entries, task, L4_SYSF_CALL,
+                                  l4_msgtag(L4_PROTO_TASK, 3, 0, 0));
+  if (!mr)
+    return -L4_ENOMEM;
+
+  mr[0] = L4_TASK_UNMAP_OP;
+  mr[1] = map_mask;
+  mr[2] = fpage.raw;
+  return 0;
+}
+
+L4_INLINE int
+l4_batch_irq_unmask(l4_batch_ring_t *ring, unsigned entries,
+                    l4_cap_idx_t irq) L4_NOTHROW
+{
+  l4_umword_t *mr = l4_batch_push(ring, entries, irq, L4_SYSF_SEND,
+                                  l4_msgtag(L4_PROTO_IRQ, 1, 0, 0));
+  if (!mr)
+    return -L4_ENOMEM;
+
+  mr[0] = L4_IRQ_OP_EOI;
+  return 0;
+}
+
+L4_INLINE int
+l4_batch_thread_ex_regs(l4_batch_ring_t *ring, unsigned entries,
+                        l4_cap_idx_t thread, l4_addr_t ip, l4_addr_t sp,
+                        l4_umword_t flags) L4_NOTHROW
+{
+  l4_umword_t *mr = l4_batch_push(ring, entries, thread, L4_SYSF_CALL,
+                                  l4_msgtag(L4_PROTO_THREAD, 3, 0, 0));
+  if (!mr)
+    return -L4_ENOMEM;
+
+  mr[0] = L4_THREAD_EX_REGS_OP | flags;
+  mr[1] = ip;
+  mr[2] = sp;
+  return 0;
+}
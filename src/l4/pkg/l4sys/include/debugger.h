@@ -160,6 +160,30 @@ L4_INLINE l4_msgtag_t
 l4_debugger_switch_log_u(l4_cap_idx_t cap, const char *name, int on_off,
                          l4_utcb_t *utcb) L4_NOTHROW;
 
+/**
+ * \brief Switch the per-CPU trace streams on or off and map them.
+ *
+ * \param task   Capability of the calling task, the streaming area can
+ *               only be mapped into the caller.
+ * \param on_off L4_DEBUGGER_SWITCH_LOG_ON to log into the per-CPU streams
+ *               instead of the global trace buffer.
+ * \param addr   Page aligned address to map the streaming area to,
+ *               read-only, or 0 to leave the mapping alone.
+ * \param size   Receives the size of the streaming area, in bytes.
+ *
+ * This is a debugging factility, the call might be invalid.
+ */
+L4_INLINE l4_msgtag_t
+l4_debugger_tbuf_stream(l4_cap_idx_t task, int on_off, l4_addr_t addr,
+                        unsigned long *size) L4_NOTHROW;
+
+/**
+ * \internal
+ */
+L4_INLINE l4_msgtag_t
+l4_debugger_tbuf_stream_u(l4_cap_idx_t task, int on_off, l4_addr_t addr,
+                          unsigned long *size, l4_utcb_t *utcb) L4_NOTHROW;
+
 enum
 {
   L4_DEBUGGER_NAME_SET_OP         = 0UL,
@@ -169,6 +193,7 @@ enum
   L4_DEBUGGER_SWITCH_LOG_OP       = 4UL,
   L4_DEBUGGER_NAME_GET_OP         = 5UL,
   L4_DEBUGGER_QUERY_LOG_NAME_OP   = 6UL,
+  L4_DEBUGGER_TBUF_STREAM_OP      = 7UL,
 };
 
 enum
@@ -285,6 +310,20 @@ l4_debugger_get_object_name_u(l4_cap_idx_t cap, unsigned id,
   return t;
 }
 
+L4_INLINE l4_msgtag_t
+l4_debugger_tbuf_stream_u(l4_cap_idx_t task, int on_off, l4_addr_t addr,
+                          unsigned long *size, l4_utcb_t *utcb) L4_NOTHROW
+{
+  l4_msgtag_t t;
+  l4_utcb_mr_u(utcb)->mr[0] = L4_DEBUGGER_TBUF_STREAM_OP;
+  l4_utcb_mr_u(utcb)->mr[1] = on_off;
+  l4_utcb_mr_u(utcb)->mr[2] = addr;
+  t = l4_invoke_debugger(task, l4_msgtag(0, 3, 0, 0), utcb);
+  if (size)
+    *size = l4_utcb_mr_u(utcb)->mr[0];
+  return t;
+}
+
 
 L4_INLINE l4_msgtag_t
 l4_debugger_set_object_name(unsigned long cap,
@@ -334,3 +373,10 @@ l4_debugger_get_object_name(l4_cap_idx_t cap, unsigned id,
 {
   return l4_debugger_get_object_name_u(cap, id, name, size, l4_utcb());
 }
+
+L4_INLINE l4_msgtag_t
+l4_debugger_tbuf_stream(l4_cap_idx_t task, int on_off, l4_addr_t addr,
+                        unsigned long *size) L4_NOTHROW
+{
+  return l4_debugger_tbuf_stream_u(task, on_off, addr, size, l4_utcb());
+}
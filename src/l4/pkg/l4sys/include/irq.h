@@ -199,6 +199,67 @@ l4_irq_unmask(l4_cap_idx_t irq) L4_NOTHROW;
 L4_INLINE l4_msgtag_t
 l4_irq_unmask_u(l4_cap_idx_t irq, l4_utcb_t *utcb) L4_NOTHROW;
 
+/**
+ * \brief Configure interrupt coalescing and polling for an IRQ.
+ * \ingroup l4_irq_api
+ *
+ * \param irq          IRQ to configure.
+ * \param max_events   Deliver one message for at most this many edge
+ *                     triggered events, 0 or 1 disables coalescing.
+ * \param max_delay_us Deliver pending events and poll ticks at the latest
+ *                     after this many microseconds.
+ * \param flags        #L4_irq_coalesce_flags.
+ *
+ * \return Syscall return tag
+ *
+ * While coalescing or polling is enabled, every IRQ message carries one
+ * word, the number of events since the last message. A message with a
+ * count of 0 is a poll tick, see l4_irq_poll_receive().
+ */
+L4_INLINE l4_msgtag_t
+l4_irq_coalesce(l4_cap_idx_t irq, unsigned long max_events,
+                unsigned long max_delay_us, unsigned flags) L4_NOTHROW;
+
+/**
+ * \internal
+ */
+L4_INLINE l4_msgtag_t
+l4_irq_coalesce_u(l4_cap_idx_t irq, unsigned long max_events,
+                  unsigned long max_delay_us, unsigned flags,
+                  l4_utcb_t *utcb) L4_NOTHROW;
+
+/**
+ * \brief Finish handling an IRQ in polling mode and wait for it.
+ * \ingroup l4_irq_api
+ *
+ * \param irq   IRQ to wait for.
+ * \param busy  If not 0, the handler has more work pending. The IRQ then
+ *              stays masked and the handler gets a poll tick after the
+ *              configured delay, otherwise the IRQ gets unmasked.
+ * \param to    Timeout.
+ *
+ * \return Syscall return tag
+ */
+L4_INLINE l4_msgtag_t
+l4_irq_poll_receive(l4_cap_idx_t irq, int busy, l4_timeout_t to) L4_NOTHROW;
+
+/**
+ * \internal
+ */
+L4_INLINE l4_msgtag_t
+l4_irq_poll_receive_u(l4_cap_idx_t irq, int busy, l4_timeout_t to,
+                      l4_utcb_t *utcb) L4_NOTHROW;
+
+/**
+ * \brief Flags for l4_irq_coalesce().
+ * \ingroup l4_irq_api
+ */
+enum L4_irq_coalesce_flags
+{
+  /** Polling mode: keep the IRQ masked while the handler is busy. */
+  L4_IRQ_COALESCE_POLL = 1,
+};
+
 /**
  * \internal
  */
@@ -208,6 +269,15 @@ enum L4_irq_op
   L4_IRQ_OP_TRIGGER   = 2,
   L4_IRQ_OP_CHAIN     = 3,
   L4_IRQ_OP_EOI       = 4,
+  L4_IRQ_OP_COALESCE  = 5,
+};
+
+/**
+ * \internal
+ */
+enum L4_irq_eoi_flags
+{
+  L4_IRQ_EOI_BUSY     = 1,
 };
 
 /**************************************************************************
@@ -276,6 +346,29 @@ l4_irq_unmask_u(l4_cap_idx_t irq, l4_utcb_t *utcb) L4_NOTHROW
   return l4_ipc_send(irq, utcb, l4_msgtag(L4_PROTO_IRQ, 1, 0, 0), L4_IPC_NEVER);
 }
 
+L4_INLINE l4_msgtag_t
+l4_irq_coalesce_u(l4_cap_idx_t irq, unsigned long max_events,
+                  unsigned long max_delay_us, unsigned flags,
+                  l4_utcb_t *utcb) L4_NOTHROW
+{
+  l4_msg_regs_t *m = l4_utcb_mr_u(utcb);
+  m->mr[0] = L4_IRQ_OP_COALESCE;
+  m->mr[1] = max_events;
+  m->mr[2] = max_delay_us;
+  m->mr[3] = flags;
+  return l4_ipc_call(irq, utcb, l4_msgtag(L4_PROTO_IRQ, 4, 0, 0), L4_IPC_NEVER);
+}
+
+L4_INLINE l4_msgtag_t
+l4_irq_poll_receive_u(l4_cap_idx_t irq, int busy, l4_timeout_t to,
+                      l4_utcb_t *utcb) L4_NOTHROW
+{
+  l4_msg_regs_t *m = l4_utcb_mr_u(utcb);
+  m->mr[0] = L4_IRQ_OP_EOI;
+  m->mr[1] = busy ? L4_IRQ_EOI_BUSY : 0;
+  return l4_ipc_call(irq, utcb, l4_msgtag(L4_PROTO_IRQ, 2, 0, 0), to);
+}
+
 
 L4_INLINE l4_msgtag_t
 l4_irq_attach(l4_cap_idx_t irq, l4_umword_t label,
@@ -322,3 +415,16 @@ l4_irq_unmask(l4_cap_idx_t irq) L4_NOTHROW
   return l4_irq_unmask_u(irq, l4_utcb());
 }
 
+L4_INLINE l4_msgtag_t
+l4_irq_coalesce(l4_cap_idx_t irq, unsigned long max_events,
+                unsigned long max_delay_us, unsigned flags) L4_NOTHROW
+{
+  return l4_irq_coalesce_u(irq, max_events, max_delay_us, flags, l4_utcb());
+}
+
+L4_INLINE l4_msgtag_t
+l4_irq_poll_receive(l4_cap_idx_t irq, int busy, l4_timeout_t to) L4_NOTHROW
+{
+  return l4_irq_poll_receive_u(irq, busy, to, l4_utcb());
+}
+
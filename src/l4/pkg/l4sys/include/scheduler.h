@@ -134,6 +134,52 @@ L4_INLINE l4_msgtag_t
 l4_scheduler_run_thread_u(l4_cap_idx_t scheduler, l4_cap_idx_t thread,
                           l4_sched_param_t const *sp, l4_utcb_t *utcb) L4_NOTHROW;
 
+/**
+ * \brief Reservation for the EDF scheduling class.
+ * \ingroup l4_scheduler_api
+ *
+ * A thread with a reservation gets \a budget µs of CPU time every
+ * \a period µs, scheduled by earliest deadline first ahead of all fixed
+ * priority threads. It is throttled until the end of the period when it
+ * uses up its budget. Only available with a kernel configured for the
+ * combined fixed priority and EDF scheduler.
+ */
+typedef struct l4_sched_param_edf_t
+{
+  l4_umword_t        budget;   ///< CPU time per period in micro seconds.
+  l4_umword_t        period;   ///< Period and relative deadline in micro seconds.
+  l4_sched_cpu_set_t affinity; ///< CPU affinity.
+} l4_sched_param_edf_t;
+
+/**
+ * \brief Construct EDF scheduler parameter.
+ * \ingroup l4_scheduler_api
+ */
+L4_INLINE l4_sched_param_edf_t
+l4_sched_param_edf(l4_umword_t budget, l4_umword_t period) L4_NOTHROW;
+
+/**
+ * \brief Run a thread with an EDF reservation on a Scheduler.
+ * \ingroup l4_scheduler_api
+ *
+ * \param scheduler  Scheduler object.
+ * \param thread Thread to run.
+ * \param sp Reservation, the budget must not exceed the period.
+ *
+ * \return 0 on success, <0 error code otherwise.
+ */
+L4_INLINE l4_msgtag_t
+l4_scheduler_run_thread_edf(l4_cap_idx_t scheduler, l4_cap_idx_t thread,
+                            l4_sched_param_edf_t const *sp) L4_NOTHROW;
+
+/**
+ * \internal
+ */
+L4_INLINE l4_msgtag_t
+l4_scheduler_run_thread_edf_u(l4_cap_idx_t scheduler, l4_cap_idx_t thread,
+                              l4_sched_param_edf_t const *sp,
+                              l4_utcb_t *utcb) L4_NOTHROW;
+
 /**
  * \brief Query idle time of a CPU, in µs.
  * \ingroup l4_scheduler_api
@@ -155,6 +201,30 @@ l4_scheduler_idle_time_u(l4_cap_idx_t scheduler, l4_sched_cpu_set_t const *cpus,
                          l4_utcb_t *utcb) L4_NOTHROW;
 
 
+/**
+ * \brief Query the load of a CPU.
+ * \ingroup l4_scheduler_api
+ *
+ * \param scheduler   Scheduler object.
+ * \param cpus        Set of CPUs to query, the first online CPU in the set
+ *                    is reported.
+ *
+ * UTCB message register 0 holds the number of ready threads on the CPU,
+ * including the running one. Register 1 holds the exponentially averaged
+ * number of ready threads as a fixed-point value with the number of
+ * fraction bits given in register 2.
+ */
+L4_INLINE l4_msgtag_t
+l4_scheduler_load_info(l4_cap_idx_t scheduler,
+                       l4_sched_cpu_set_t const *cpus) L4_NOTHROW;
+
+/**
+ * \internal
+ */
+L4_INLINE l4_msgtag_t
+l4_scheduler_load_info_u(l4_cap_idx_t scheduler, l4_sched_cpu_set_t const *cpus,
+                         l4_utcb_t *utcb) L4_NOTHROW;
+
 
 /**
  * \brief Query if a CPU is online.
@@ -187,6 +257,17 @@ enum L4_scheduler_ops
   L4_SCHEDULER_INFO_OP       = 0UL, /**< Query infos about the scheduler */
   L4_SCHEDULER_RUN_THREAD_OP = 1UL, /**< Run a thread on this scheduler */
   L4_SCHEDULER_IDLE_TIME_OP  = 2UL, /**< Query idle time for the scheduler */
+  L4_SCHEDULER_LOAD_INFO_OP  = 3UL, /**< Query load of a CPU */
+};
+
+/**
+ * \brief Scheduling classes for L4_SCHEDULER_RUN_THREAD_OP.
+ * \ingroup l4_scheduler_api
+ * \internal
+ */
+enum L4_sched_class
+{
+  L4_SCHED_CLASS_EDF = -3, /**< Reservation-based EDF */
 };
 
 /*************** Implementations *******************/
@@ -252,6 +333,35 @@ l4_scheduler_run_thread_u(l4_cap_idx_t scheduler, l4_cap_idx_t thread,
   return l4_ipc_call(scheduler, utcb, l4_msgtag(L4_PROTO_SCHEDULER, 5, 1, 0), L4_IPC_NEVER);
 }
 
+L4_INLINE l4_sched_param_edf_t
+l4_sched_param_edf(l4_umword_t budget, l4_umword_t period) L4_NOTHROW
+{
+  l4_sched_param_edf_t sp;
+  sp.budget   = budget;
+  sp.period   = period;
+  sp.affinity = l4_sched_cpu_set(0, ~0, 1);
+  return sp;
+}
+
+L4_INLINE l4_msgtag_t
+l4_scheduler_run_thread_edf_u(l4_cap_idx_t scheduler, l4_cap_idx_t thread,
+                              l4_sched_param_edf_t const *sp,
+                              l4_utcb_t *utcb) L4_NOTHROW
+{
+  l4_msg_regs_t *m = l4_utcb_mr_u(utcb);
+  m->mr[0] = L4_SCHEDULER_RUN_THREAD_OP;
+  m->mr[1] = (sp->affinity.granularity << 24) | sp->affinity.offset;
+  m->mr[2] = sp->affinity.map;
+  m->mr[3] = (l4_umword_t)L4_SCHED_CLASS_EDF;
+  m->mr[4] = 6 * sizeof(l4_umword_t); /* cpus, class, length, budget, period */
+  m->mr[5] = sp->budget;
+  m->mr[6] = sp->period;
+  m->mr[7] = l4_map_obj_control(0, 0);
+  m->mr[8] = l4_obj_fpage(thread, 0, L4_FPAGE_RWX).raw;
+
+  return l4_ipc_call(scheduler, utcb, l4_msgtag(L4_PROTO_SCHEDULER, 7, 1, 0), L4_IPC_NEVER);
+}
+
 L4_INLINE l4_msgtag_t
 l4_scheduler_idle_time_u(l4_cap_idx_t scheduler, l4_sched_cpu_set_t const *cpus,
                          l4_utcb_t *utcb) L4_NOTHROW
@@ -263,6 +373,17 @@ l4_scheduler_idle_time_u(l4_cap_idx_t scheduler, l4_sched_cpu_set_t const *cpus,
   return l4_ipc_call(scheduler, utcb, l4_msgtag(L4_PROTO_SCHEDULER, 3, 0, 0), L4_IPC_NEVER);
 }
 
+L4_INLINE l4_msgtag_t
+l4_scheduler_load_info_u(l4_cap_idx_t scheduler, l4_sched_cpu_set_t const *cpus,
+                         l4_utcb_t *utcb) L4_NOTHROW
+{
+  l4_msg_regs_t *v = l4_utcb_mr_u(utcb);
+  v->mr[0] = L4_SCHEDULER_LOAD_INFO_OP;
+  v->mr[1] = (cpus->granularity << 24) | cpus->offset;
+  v->mr[2] = cpus->map;
+  return l4_ipc_call(scheduler, utcb, l4_msgtag(L4_PROTO_SCHEDULER, 3, 0, 0), L4_IPC_NEVER);
+}
+
 
 L4_INLINE int
 l4_scheduler_is_online_u(l4_cap_idx_t scheduler, l4_umword_t cpu,
@@ -294,12 +415,26 @@ l4_scheduler_run_thread(l4_cap_idx_t scheduler,
   return l4_scheduler_run_thread_u(scheduler, thread, sp, l4_utcb());
 }
 
+L4_INLINE l4_msgtag_t
+l4_scheduler_run_thread_edf(l4_cap_idx_t scheduler, l4_cap_idx_t thread,
+                            l4_sched_param_edf_t const *sp) L4_NOTHROW
+{
+  return l4_scheduler_run_thread_edf_u(scheduler, thread, sp, l4_utcb());
+}
+
 L4_INLINE l4_msgtag_t
 l4_scheduler_idle_time(l4_cap_idx_t scheduler, l4_sched_cpu_set_t const *cpus) L4_NOTHROW
 {
   return l4_scheduler_idle_time_u(scheduler, cpus, l4_utcb());
 }
 
+L4_INLINE l4_msgtag_t
+l4_scheduler_load_info(l4_cap_idx_t scheduler,
+                       l4_sched_cpu_set_t const *cpus) L4_NOTHROW
+{
+  return l4_scheduler_load_info_u(scheduler, cpus, l4_utcb());
+}
+
 L4_INLINE int
 l4_scheduler_is_online(l4_cap_idx_t scheduler, l4_umword_t cpu) L4_NOTHROW
 {
@@ -481,6 +481,50 @@ l4_thread_vcpu_control_ext_u(l4_cap_idx_t thread, l4_addr_t ext_vcpu_state,
                              l4_utcb_t *utcb) L4_NOTHROW;
 
 
+/**
+ * \brief Register the submission ring of a thread.
+ * \ingroup l4_thread_api
+ *
+ * \param thread  The calling thread itself.
+ * \param ring    Address of the ring, see \ref l4_batch_ring_t. The ring
+ *                must be in kernel-user memory. 0 unregisters the ring.
+ * \param entries Number of entries of the ring, a power of two.
+ * \return System call result message tag.
+ */
+L4_INLINE l4_msgtag_t
+l4_thread_batch_control(l4_cap_idx_t thread, l4_addr_t ring,
+                        unsigned entries) L4_NOTHROW;
+
+/**
+ * \internal
+ * \ingroup l4_thread_api
+ */
+L4_INLINE l4_msgtag_t
+l4_thread_batch_control_u(l4_cap_idx_t thread, l4_addr_t ring,
+                          unsigned entries, l4_utcb_t *utcb) L4_NOTHROW;
+
+/**
+ * \brief Execute the pending entries of the submission ring.
+ * \ingroup l4_thread_api
+ *
+ * \param thread The calling thread itself.
+ * \return System call result message tag, the label holds the number of
+ *         executed entries, or a negative error code.
+ *
+ * The entries are executed in order and the result of each one is written
+ * back into the entry. The call overwrites the message registers.
+ * \see l4/sys/batch.h
+ */
+L4_INLINE l4_msgtag_t
+l4_thread_batch_submit(l4_cap_idx_t thread) L4_NOTHROW;
+
+/**
+ * \internal
+ * \ingroup l4_thread_api
+ */
+L4_INLINE l4_msgtag_t
+l4_thread_batch_submit_u(l4_cap_idx_t thread, l4_utcb_t *utcb) L4_NOTHROW;
+
 /**
  * \brief Register an IRQ that will trigger upon deletion events.
  * \ingroup l4_thread_api
@@ -599,6 +643,8 @@ enum L4_thread_ops
   L4_THREAD_MODIFY_SENDER_OP          = 6UL,    /**< Modify all senders IDs that match the given pattern */
   L4_THREAD_VCPU_CONTROL_OP           = 7UL,    /**< Enable / disable VCPU feature */
   L4_THREAD_VCPU_CONTROL_EXT_OP       = L4_THREAD_VCPU_CONTROL_OP | 0x10000,
+  L4_THREAD_BATCH_CONTROL_OP          = 8UL,    /**< Register a submission ring */
+  L4_THREAD_BATCH_SUBMIT_OP           = 9UL,    /**< Execute the submission ring */
   L4_THREAD_X86_GDT_OP                = 0x10UL, /**< Gdt */
   L4_THREAD_ARM_TPIDRURO_OP           = 0x10UL, /**< Set TPIDRURO register */
   L4_THREAD_AMD64_SET_SEGMENT_BASE_OP = 0x12UL, /**< Set segment base */
@@ -929,6 +975,33 @@ L4_INLINE l4_msgtag_t
 l4_thread_vcpu_control_ext(l4_cap_idx_t thread, l4_addr_t ext_vcpu_state) L4_NOTHROW
 { return l4_thread_vcpu_control_ext_u(thread, ext_vcpu_state, l4_utcb()); }
 
+L4_INLINE l4_msgtag_t
+l4_thread_batch_control_u(l4_cap_idx_t thread, l4_addr_t ring,
+                          unsigned entries, l4_utcb_t *utcb) L4_NOTHROW
+{
+  l4_msg_regs_t *v = l4_utcb_mr_u(utcb);
+  v->mr[0] = L4_THREAD_BATCH_CONTROL_OP;
+  v->mr[1] = ring;
+  v->mr[2] = entries;
+  return l4_ipc_call(thread, utcb, l4_msgtag(L4_PROTO_THREAD, 3, 0, 0), L4_IPC_NEVER);
+}
+
+L4_INLINE l4_msgtag_t
+l4_thread_batch_control(l4_cap_idx_t thread, l4_addr_t ring,
+                        unsigned entries) L4_NOTHROW
+{ return l4_thread_batch_control_u(thread, ring, entries, l4_utcb()); }
+
+L4_INLINE l4_msgtag_t
+l4_thread_batch_submit_u(l4_cap_idx_t thread, l4_utcb_t *utcb) L4_NOTHROW
+{
+  l4_utcb_mr_u(utcb)->mr[0] = L4_THREAD_BATCH_SUBMIT_OP;
+  return l4_ipc_call(thread, utcb, l4_msgtag(L4_PROTO_THREAD, 1, 0, 0), L4_IPC_NEVER);
+}
+
+L4_INLINE l4_msgtag_t
+l4_thread_batch_submit(l4_cap_idx_t thread) L4_NOTHROW
+{ return l4_thread_batch_submit_u(thread, l4_utcb()); }
+
 L4_INLINE l4_msgtag_t
 l4_thread_modify_sender_start_u(l4_utcb_t *u) L4_NOTHROW
 {
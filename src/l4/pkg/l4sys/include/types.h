@@ -302,6 +302,27 @@ L4_INLINE unsigned l4_msgtag_is_sigma0(l4_msgtag_t t) L4_NOTHROW;
  */
 L4_INLINE unsigned l4_msgtag_is_io_page_fault(l4_msgtag_t t) L4_NOTHROW;
 
+/**
+ * \brief Stride of the fault-around hint of a page-fault message.
+ * \ingroup l4_msgtag_api
+ * \param hint The third word of the page-fault message.
+ * \return Distance between the last page faults of the thread in bytes,
+ *         negative for descending accesses.
+ *
+ * The kernel tracks the access pattern of the page faults of each thread.
+ * Pagers may map a window of pages that covers the upcoming accesses.
+ */
+L4_INLINE long l4_pf_hint_stride(l4_umword_t hint) L4_NOTHROW;
+
+/**
+ * \brief Length of the fault pattern of a page-fault message.
+ * \ingroup l4_msgtag_api
+ * \param hint The third word of the page-fault message.
+ * \return Number of page faults in a row that were l4_pf_hint_stride()
+ *         apart, 0 if the fault does not follow a pattern.
+ */
+L4_INLINE unsigned l4_pf_hint_run(l4_umword_t hint) L4_NOTHROW;
+
 /**
  * \defgroup l4_cap_api Capabilities
  * \ingroup l4_api
@@ -414,5 +435,11 @@ L4_INLINE unsigned l4_msgtag_is_sigma0(l4_msgtag_t t) L4_NOTHROW
 L4_INLINE unsigned l4_msgtag_is_io_page_fault(l4_msgtag_t t) L4_NOTHROW
 { return l4_msgtag_label(t) == L4_PROTO_IO_PAGE_FAULT; }
 
+L4_INLINE long l4_pf_hint_stride(l4_umword_t hint) L4_NOTHROW
+{ return (long)(hint & L4_PAGEMASK); }
+
+L4_INLINE unsigned l4_pf_hint_run(l4_umword_t hint) L4_NOTHROW
+{ return hint & ~L4_PAGEMASK; }
+
 #include <l4/sys/__l4_fpage.h>
 #include <l4/sys/__timeout.h>
@@ -0,0 +1,141 @@
+/**
+ * \file
+ * \brief Streaming consumer for the per-CPU kernel trace buffers.
+ */
+/*
+ * This file is part of TUD:OS and distributed under the terms of the
+ * GNU General Public License 2.
+ * Please see the COPYING-GPL-2 file for details.
+ */
+#pragma once
+
+#include <l4/sys/compiler.h>
+#include <l4/sys/types.h>
+
+#include <stdio.h>
+
+__BEGIN_DECLS
+
+/**
+ * \defgroup l4tbuf_api Kernel trace stream library
+ *
+ * With streaming switched on, the kernel logs trace events into one ring
+ * per CPU instead of into the global trace buffer of the kernel debugger.
+ * The rings are mapped read-only into the consuming task, which has to
+ * drain them faster than they fill up. Entries overwritten before they
+ * were read are counted as lost.
+ *
+ * The entries are raw kernel trace buffer entries (see Tb_entry in the
+ * kernel sources), each carrying the number of the CPU it was logged on.
+ * The entry number counts per CPU while streaming.
+ *
+ * Requires a kernel with the kernel debugger and the trace buffer.
+ */
+
+enum
+{
+  L4TBUF_STREAM_CPUS = 32, /**< Maximum number of streaming CPUs */
+};
+
+/**
+ * \brief Trace stream of one CPU, as shared with the kernel.
+ * \ingroup l4tbuf_api
+ */
+typedef struct l4tbuf_stream_cpu_t
+{
+  l4_umword_t head;    /**< Number of committed entries */
+  l4_umword_t entries; /**< Ring size in entries, 0 if the CPU has none */
+  l4_umword_t offset;  /**< Offset of the ring in the streaming area */
+  l4_umword_t _pad[5];
+} l4tbuf_stream_cpu_t;
+
+/**
+ * \brief First page of the streaming area, as shared with the kernel.
+ * \ingroup l4tbuf_api
+ *
+ * The latency histograms of CPU L4_LAT_HIST_CPUS + n are at slot n of an
+ * array laid out like l4_tracebuffer_status_t::lat_hist, lat_hist_offset
+ * bytes from the start of the area.
+ */
+typedef struct l4tbuf_stream_status_t
+{
+  l4_umword_t entry_size;      /**< Size of a trace buffer entry in bytes */
+  l4_umword_t cpus;            /**< Number of valid cpu[] slots */
+  l4_umword_t lat_hist_offset; /**< Offset of the further histograms */
+  l4_umword_t lat_hist_cpus;   /**< Number of CPUs there, 0 if none */
+  l4_umword_t _pad[4];
+  l4tbuf_stream_cpu_t cpu[L4TBUF_STREAM_CPUS];
+} l4tbuf_stream_status_t;
+
+struct l4tbuf_stream_t;
+typedef struct l4tbuf_stream_t l4tbuf_stream_t;
+
+/**
+ * \brief Map the trace streams and switch streaming on.
+ * \ingroup l4tbuf_api
+ *
+ * \return Stream handle, 0 on error
+ */
+L4_CV l4tbuf_stream_t *
+l4tbuf_stream_open(void);
+
+/**
+ * \brief Switch streaming off and release the stream handle.
+ * \ingroup l4tbuf_api
+ *
+ * Unmaps the streaming area and hands its region back to the region
+ * manager.
+ */
+L4_CV void
+l4tbuf_stream_close(l4tbuf_stream_t *s);
+
+/**
+ * \brief Status page of the streaming area.
+ * \ingroup l4tbuf_api
+ */
+L4_CV l4tbuf_stream_status_t const *
+l4tbuf_stream_status(l4tbuf_stream_t *s);
+
+/**
+ * \brief Copy new entries of one CPU.
+ * \ingroup l4tbuf_api
+ *
+ * \param s     Stream handle.
+ * \param cpu   CPU to read from.
+ * \param buf   Buffer for max entries of l4tbuf_stream_status()->entry_size
+ *              bytes each.
+ * \param max   Maximum number of entries to copy.
+ * \param lost  Incremented by the number of entries lost, may be 0.
+ * \return Number of entries copied.
+ */
+L4_CV unsigned long
+l4tbuf_stream_read(l4tbuf_stream_t *s, unsigned cpu, void *buf,
+                   unsigned long max, unsigned long *lost);
+
+/**
+ * \brief Write all new entries of all CPUs to a file.
+ * \ingroup l4tbuf_api
+ *
+ * \param s     Stream handle.
+ * \param f     File to write the raw entries to.
+ * \param lost  Incremented by the number of entries lost, may be 0.
+ * \return Number of entries written, -1 on write error.
+ */
+L4_CV long
+l4tbuf_stream_drain(l4tbuf_stream_t *s, FILE *f, unsigned long *lost);
+
+/**
+ * \brief Drain the streams to a file until an error occurs.
+ * \ingroup l4tbuf_api
+ *
+ * \param s         Stream handle.
+ * \param f         File to write the raw entries to.
+ * \param idle_us   Time to sleep when all rings were empty.
+ * \param lost      Counts the entries lost, may be 0.
+ * \return -1 on write error.
+ */
+L4_CV int
+l4tbuf_stream_run(l4tbuf_stream_t *s, FILE *f, unsigned idle_us,
+                  unsigned long volatile *lost);
+
+__END_DECLS
@@ -0,0 +1,185 @@
+/**
+ * \file
+ * \brief Streaming consumer for the per-CPU kernel trace buffers.
+ */
+/*
+ * This file is part of TUD:OS and distributed under the terms of the
+ * GNU General Public License 2.
+ * Please see the COPYING-GPL-2 file for details.
+ */
+
+#include <l4/tbuf/tbuf.h>
+#include <l4/re/env>
+#include <l4/re/rm>
+#include <l4/sys/debugger.h>
+#include <l4/sys/task.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+enum { Drain_size = 256 * 128 };
+
+struct l4tbuf_stream_t
+{
+  l4_addr_t area;
+  unsigned long size;
+  l4tbuf_stream_status_t const *status;
+  l4_umword_t tail[L4TBUF_STREAM_CPUS];
+  char buf[Drain_size];
+};
+
+L4_CV l4tbuf_stream_t *
+l4tbuf_stream_open(void)
+{
+  L4Re::Env const *env = L4Re::Env::env();
+  unsigned long size;
+
+  // the first call allocates the streams and tells their size
+  if (l4_error(l4_debugger_tbuf_stream(L4RE_THIS_TASK_CAP,
+                                       L4_DEBUGGER_SWITCH_LOG_OFF, 0, &size)))
+    return 0;
+
+  l4tbuf_stream_t *s = (l4tbuf_stream_t *)calloc(1, sizeof(*s));
+  if (!s)
+    return 0;
+
+  // keep the region manager away from the area, the kernel maps it
+  s->size = size;
+  if (env->rm()->reserve_area(&s->area, size, L4Re::Rm::Search_addr))
+    {
+      free(s);
+      return 0;
+    }
+
+  if (l4_error(l4_debugger_tbuf_stream(L4RE_THIS_TASK_CAP,
+                                       L4_DEBUGGER_SWITCH_LOG_ON, s->area,
+                                       &size)))
+    {
+      env->rm()->free_area(s->area);
+      free(s);
+      return 0;
+    }
+
+  s->status = (l4tbuf_stream_status_t const *)s->area;
+  for (unsigned c = 0; c < s->status->cpus; ++c)
+    s->tail[c] = s->status->cpu[c].head;
+
+  return s;
+}
+
+L4_CV void
+l4tbuf_stream_close(l4tbuf_stream_t *s)
+{
+  l4_debugger_tbuf_stream(L4RE_THIS_TASK_CAP, L4_DEBUGGER_SWITCH_LOG_OFF, 0, 0);
+
+  // drop the kernel's mapping before the region manager reuses the area
+  for (l4_addr_t a = s->area; a < s->area + s->size; a += L4_PAGESIZE)
+    l4_task_unmap(L4RE_THIS_TASK_CAP,
+                  l4_fpage(a, L4_PAGESHIFT, L4_FPAGE_RWX),
+                  L4_FP_ALL_SPACES);
+
+  L4Re::Env::env()->rm()->free_area(s->area);
+  free(s);
+}
+
+L4_CV l4tbuf_stream_status_t const *
+l4tbuf_stream_status(l4tbuf_stream_t *s)
+{ return s->status; }
+
+L4_CV unsigned long
+l4tbuf_stream_read(l4tbuf_stream_t *s, unsigned cpu, void *buf,
+                   unsigned long max, unsigned long *lost)
+{
+  if (cpu >= s->status->cpus)
+    return 0;
+
+  l4tbuf_stream_cpu_t const volatile *c = &s->status->cpu[cpu];
+  l4_umword_t const entries = c->entries;
+  l4_umword_t const esize = s->status->entry_size;
+  char const *ring = (char const *)s->area + c->offset;
+  if (!entries)
+    return 0;
+
+  l4_umword_t tail = s->tail[cpu];
+  l4_umword_t head = c->head;
+  l4_umword_t missed = 0;
+  __sync_synchronize();
+
+  if (head - tail > entries)
+    {
+      missed = head - entries - tail;
+      tail = head - entries;
+    }
+
+  unsigned long n = head - tail;
+  if (n > max)
+    n = max;
+
+  for (unsigned long i = 0; i < n; ++i)
+    memcpy((char *)buf + i * esize,
+           ring + ((tail + i) & (entries - 1)) * esize, esize);
+
+  // Entries the kernel overwrote while we were copying are lost, the
+  // slot of entry head2 may be half written already.
+  __sync_synchronize();
+  l4_umword_t head2 = c->head;
+  unsigned long bad = 0;
+  if (head2 - tail >= entries)
+    bad = head2 - entries - tail + 1;
+  if (bad > n)
+    bad = n;
+
+  if (bad)
+    memmove(buf, (char *)buf + bad * esize, (n - bad) * esize);
+
+  s->tail[cpu] = tail + n;
+  if (lost)
+    *lost += missed + bad;
+  return n - bad;
+}
+
+L4_CV long
+l4tbuf_stream_drain(l4tbuf_stream_t *s, FILE *f, unsigned long *lost)
+{
+  l4_umword_t const esize = s->status->entry_size;
+  unsigned long const max = sizeof(s->buf) / esize;
+  long total = 0;
+
+  for (unsigned c = 0; c < s->status->cpus; ++c)
+    {
+      unsigned long n;
+      while ((n = l4tbuf_stream_read(s, c, s->buf, max, lost)))
+        {
+          if (fwrite(s->buf, esize, n, f) != n)
+            return -1;
+          total += n;
+          if (n < max)
+            break;
+        }
+    }
+
+  return total;
+}
+
+L4_CV int
+l4tbuf_stream_run(l4tbuf_stream_t *s, FILE *f, unsigned idle_us,
+                  unsigned long volatile *lost)
+{
+  for (;;)
+    {
+      unsigned long l = 0;
+      long n = l4tbuf_stream_drain(s, f, &l);
+      if (n < 0)
+        return -1;
+
+      if (lost)
+        *lost += l;
+
+      if (!n)
+        {
+          fflush(f);
+          usleep(idle_us);
+        }
+    }
+}
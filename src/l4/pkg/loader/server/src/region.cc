@@ -85,7 +85,8 @@ void Region_map::global_init()
 
 int
 Region_ops::map(Region_handler const *h, l4_addr_t local_adr,
-                Region const &r, bool writable, L4::Ipc::Snd_fpage *result)
+                Region const &r, bool writable, unsigned char /*around*/,
+                L4::Ipc::Snd_fpage *result)
 {
   if ((h->flags() & Rm::Reserved) || !h->memory().is_valid())
     return -L4_ENOENT;
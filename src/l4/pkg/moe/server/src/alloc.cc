@@ -22,6 +22,7 @@
 #include "alloc.h"
 #include "dataspace_annon.h"
 #include "dataspace_noncont.h"
+#include "dataspace_util.h"
 #include "globals.h"
 #include "page_alloc.h"
 #include "slab_alloc.h"
@@ -116,6 +117,16 @@ Allocator::alloc(unsigned long size, unsigned long flags, unsigned long align)
   return mo;
 }
 
+Moe::Dataspace *
+Allocator::clone(Moe::Dataspace const *src)
+{
+  cxx::Auto_ptr<Moe::Dataspace_noncont>
+    mo(Moe::Dataspace_noncont::create(&_quota, src->size()));
+
+  Dataspace_util::clone(mo.get(), src);
+  return mo.release();
+}
+
 Allocator::~Allocator()
 {
   if (Q_object::quota())
@@ -329,6 +340,25 @@ Allocator::dispatch(l4_umword_t obj, L4::Ipc::Iostream &ios)
               mo.release();
               return L4_EOK;
             }
+          case L4Re::Mem_alloc_::Clone:
+            {
+              L4::Ipc::Snd_fpage src_cap;
+              Moe::Dataspace *src = 0;
+              ios >> src_cap;
+
+              if (src_cap.id_received())
+                src = dynamic_cast<Moe::Dataspace*>(object_pool.find(src_cap.data()));
+
+              if (!src)
+                return -L4_EINVAL;
+
+              cxx::Auto_ptr<Moe::Dataspace> mo(clone(src));
+              L4::Cap<L4::Kobject> ko = object_pool.cap_alloc()->alloc(mo.get());
+              ko->dec_refcnt(1);
+              ios << ko;
+              mo.release();
+              return L4_EOK;
+            }
           case L4Re::Mem_alloc_::Free:
             {
               l4_umword_t rc1, rc2;
@@ -359,6 +389,7 @@ Allocator::dispatch(l4_umword_t obj, L4::Ipc::Iostream &ios)
                _quota.limit(), _quota.used());
         printf("MOE: mem_alloc: global: avail=%ld Byte\n",
                Single_page_alloc_base::_avail());
+        Single_page_alloc_base::_dump_stats();
         return L4_EOK;
       }
 #endif
@@ -35,6 +35,7 @@ public:
 
   Moe::Dataspace *alloc(unsigned long size, unsigned long flags = 0,
                         unsigned long align = 0);
+  Moe::Dataspace *clone(Moe::Dataspace const *src);
 
   virtual ~Allocator();
 
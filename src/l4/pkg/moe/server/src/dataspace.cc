@@ -28,7 +28,8 @@ using cxx::min;
 
 int
 Moe::Dataspace::map(l4_addr_t offs, l4_addr_t hot_spot, bool _rw,
-                    l4_addr_t min, l4_addr_t max, L4::Ipc::Snd_fpage &memory)
+                    l4_addr_t min, l4_addr_t max, L4::Ipc::Snd_fpage &memory,
+                    unsigned char around)
 {
   memory = L4::Ipc::Snd_fpage();
 
@@ -45,7 +46,11 @@ Moe::Dataspace::map(l4_addr_t offs, l4_addr_t hot_spot, bool _rw,
     }
 
   Ds_rw rw = _rw ? Writable : Read_only;
-  Address adr = address(offs, rw, hot_spot, min, max);
+  Address adr(-L4_ENOENT);
+  if (around > page_shift())
+    adr = address_around(offs, rw, around, hot_spot, min, max);
+  if (adr.is_nil())
+    adr = address(offs, rw, hot_spot, min, max);
   if (adr.is_nil())
     return -L4_EPERM;
 
@@ -59,6 +64,70 @@ Moe::Dataspace::map(l4_addr_t offs, l4_addr_t hot_spot, bool _rw,
   return L4_EOK;
 }
 
+/**
+ * Map the window of 2^order bytes at offs with up to *items flex pages.
+ * On return, *items is the number of flex pages and *mapped the number of
+ * bytes they cover from the start of the window.
+ */
+int
+Moe::Dataspace::map_region(l4_addr_t offs, unsigned char order, bool _rw,
+                           L4::Ipc::Snd_fpage *memory, unsigned *items,
+                           unsigned long *mapped)
+{
+  unsigned long const win = 1UL << order;
+  unsigned const max = *items;
+  unsigned long done = 0;
+  unsigned n = 0;
+
+  offs = l4_trunc_page(offs);
+  Ds_rw rw = _rw ? Writable : Read_only;
+  L4::Ipc::Snd_fpage::Cacheopt cache
+    = (L4::Ipc::Snd_fpage::Cacheopt)((_flags >> 12) & (7 << 4));
+
+  while (done < win && n < max && check_limit(offs + done))
+    {
+      // largest block aligned in the data space and in the window
+      unsigned char o = order;
+      while (o > page_shift()
+             && ((((offs + done) | done) & ((1UL << o) - 1))
+                 || done + (1UL << o) > win))
+        --o;
+
+      Address adr(-L4_ENOENT);
+      try
+        {
+          if (o > page_shift())
+            adr = address_around(offs + done, rw, o, done, 0, win - 1);
+          if (adr.is_nil())
+            adr = address(offs + done, rw, done, 0, win - 1);
+        }
+      catch (L4::Out_of_memory const &)
+        {
+          // the pages mapped so far are fine
+          if (!n)
+            throw;
+        }
+
+      if (adr.is_nil())
+        {
+          if (!n)
+            return -L4_EPERM;
+          break;
+        }
+
+      memory[n++] = L4::Ipc::Snd_fpage(adr.fp(), done, L4::Ipc::Snd_fpage::Map,
+                                       cache, L4::Ipc::Snd_fpage::Compound);
+      done += adr.sz() - adr.of();
+    }
+
+  if (!n)
+    return -L4_ERANGE;
+
+  *items = n;
+  *mapped = cxx::min(done, win);
+  return L4_EOK;
+}
+
 inline
 L4::Ipc::Ostream &operator << (L4::Ipc::Ostream &s,
                               L4Re::Dataspace::Stats const &st)
@@ -99,7 +168,9 @@ Moe::Dataspace::dispatch(l4_umword_t obj, L4::Ipc::Iostream &ios)
         if (read_only && (flags & Writable))
           return -L4_EPERM;
 
-        long int ret = map(offset, spot, flags & Writable, 0, ~0, fp);
+        unsigned char around = (flags & L4Re::Dataspace::Map_around_mask)
+                               >> L4Re::Dataspace::Map_around_shift;
+        long int ret = map(offset, spot, flags & Writable, 0, ~0, fp, around);
 
         if (0)
           L4::cout << "MAP: " << L4::hex << reinterpret_cast<unsigned long *>(&fp)[0]
@@ -110,6 +181,34 @@ Moe::Dataspace::dispatch(l4_umword_t obj, L4::Ipc::Iostream &ios)
         if (ret == L4_EOK)
           ios << fp;
 
+        return ret;
+      }
+    case L4Re::Dataspace_::Map_region:
+      {
+        bool read_only = !is_writable() || !(obj & L4_CAP_FPAGE_W);
+        l4_addr_t offset;
+        l4_umword_t order;
+        unsigned long flags;
+        ios >> offset >> order >> flags;
+
+        if (read_only && (flags & Writable))
+          return -L4_EPERM;
+
+        if (order < page_shift() || order >= sizeof(l4_addr_t) * 8)
+          return -L4_EINVAL;
+
+        L4::Ipc::Snd_fpage fp[Map_region_items];
+        unsigned items = Map_region_items;
+        unsigned long mapped;
+        long int ret = map_region(offset, order, flags & Writable, fp,
+                                  &items, &mapped);
+        if (ret == L4_EOK)
+          {
+            ios << l4_umword_t(mapped);
+            for (unsigned i = 0; i < items; ++i)
+              ios << fp[i];
+          }
+
         return ret;
       }
     case L4Re::Dataspace_::Clear:
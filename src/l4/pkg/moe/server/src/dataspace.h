@@ -34,6 +34,12 @@ public:
     Cow_enabled = 0x100,
   };
 
+  enum
+  {
+    /// Flex pages per map-region reply, next to the mapped size
+    Map_region_items = (L4_UTCB_GENERIC_DATA_SIZE - 1) / 2,
+  };
+
   struct Address
   {
     l4_fpage_t fpage;
@@ -76,6 +82,24 @@ public:
                           Ds_rw rw = Writable, l4_addr_t hot_spot = 0,
                           l4_addr_t min = 0, l4_addr_t max = ~0) const = 0;
 
+  /**
+   * \brief Address of the naturally aligned block of 2^order bytes around
+   *        ds_offset, for fault-around.
+   *
+   * Like address(), the block must be congruent to hot_spot and fit into
+   * the receive window [min, max], smaller blocks are tried otherwise.
+   *
+   * \return The block, or a nil address if it cannot be mapped at once.
+   */
+  virtual Address address_around(l4_addr_t ds_offset, Ds_rw rw,
+                                 unsigned char order, l4_addr_t hot_spot,
+                                 l4_addr_t min, l4_addr_t max) const
+  {
+    (void)ds_offset; (void)rw; (void)order;
+    (void)hot_spot; (void)min; (void)max;
+    return Address(-L4_ENOENT);
+  }
+
   virtual int pre_allocate(l4_addr_t offset, l4_size_t size, unsigned rights) = 0;
 
   unsigned long is_writable() const throw() { return _flags & Writable; }
@@ -101,7 +125,11 @@ public:
 public:
   int dispatch(l4_umword_t obj, L4::Ipc::Iostream &ios);
   int map(l4_addr_t offs, l4_addr_t spot, bool rw,
-          l4_addr_t min, l4_addr_t max, L4::Ipc::Snd_fpage &memory);
+          l4_addr_t min, l4_addr_t max, L4::Ipc::Snd_fpage &memory,
+          unsigned char around = 0);
+  int map_region(l4_addr_t offs, unsigned char order, bool rw,
+                 L4::Ipc::Snd_fpage *memory, unsigned *items,
+                 unsigned long *mapped);
   int stats(L4Re::Dataspace::Stats &stats);
   //int copy_in(unsigned long dst_offs, Dataspace *src, unsigned long src_offs,
   //    unsigned long size);
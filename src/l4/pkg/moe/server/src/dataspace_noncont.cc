@@ -88,6 +88,90 @@ Moe::Dataspace_noncont::address(l4_addr_t offset,
   return Address(l4_addr_t(*p), page_shift(), rw, offset & (page_size()-1));
 }
 
+/**
+ * Fault-around: back the block around offset with contiguous memory if
+ * none of its pages is allocated yet, or find it already backed that way.
+ * Smaller blocks are tried if the block is partly populated.
+ */
+Moe::Dataspace::Address
+Moe::Dataspace_noncont::address_around(l4_addr_t offset, Ds_rw rw,
+                                       unsigned char order, l4_addr_t hot_spot,
+                                       l4_addr_t min, l4_addr_t max) const
+{
+  if (!check_limit(offset))
+    return Address(-L4_ERANGE);
+
+  if (!is_writable())
+    rw = Read_only;
+
+  if (order >= L4_MWORD_BITS)
+    order = L4_MWORD_BITS - 1;
+
+  min = l4_trunc_page(min);
+  for (; order > page_shift(); --order)
+    {
+      unsigned long const sz = 1UL << order;
+      l4_addr_t const base = l4_trunc_size(offset, order);
+      if (base + sz > round_size())
+        continue;
+
+      // the block has to land at hot_spot and stay inside the window
+      l4_addr_t const map_base = l4_trunc_size(hot_spot, order);
+      if (((offset ^ hot_spot) & (sz - 1))
+          || map_base < min || map_base + sz - 1 > max)
+        continue;
+
+      unsigned long const first = (unsigned long)*page(base);
+      bool empty = true, backed = first && !(first & (sz - 1));
+      for (l4_addr_t o = 0; o < sz && (empty || backed); o += page_size())
+        {
+          Page const &p = page(base + o);
+          if (p.valid())
+            empty = false;
+          if ((unsigned long)*p != first + o
+              || (rw == Writable && (p.flags() & Page_cow)))
+            backed = false;
+        }
+
+      if (backed)
+        return Address(first, order, rw, offset - base);
+
+      if (!empty)
+        continue;
+
+      void *b;
+      try
+        {
+          b = Page_alloc::_alloc(quota(), sz, sz);
+        }
+      catch (L4::Out_of_memory const &)
+        {
+          continue;
+        }
+
+      memset(b, 0, sz);
+      for (l4_addr_t o = 0; o < sz; o += page_size())
+        {
+          void *pg = (char *)b + o;
+          try
+            {
+              alloc_page(base + o).set(pg, 0);
+            }
+          catch (L4::Out_of_memory const &)
+            {
+              // no page table, the pages set so far belong to us already
+              Page_alloc::_free(quota(), pg, sz - o);
+              return Address(-L4_ENOMEM);
+            }
+          Moe::Pages::share(pg);
+        }
+
+      return Address(l4_addr_t(b), order, rw, offset - base);
+    }
+
+  return Address(-L4_ENOENT);
+}
+
 int
 Moe::Dataspace_noncont::pre_allocate(l4_addr_t offset, l4_size_t size, unsigned rights)
 {
@@ -217,6 +301,18 @@ namespace {
 
   };
 
+  /**
+   * Data space with a two-level page array.
+   *
+   * Each first-level entry covers a naturally aligned large page of
+   * entries2() pages. It either points to a second-level table of pages,
+   * or, for large pages backed by one contiguous chunk, to the chunk
+   * itself, which is then mapped with large flex pages and needs no
+   * second-level table. Large pages are allocated on the first access to
+   * an empty large page if the page allocator has a free chunk, and are
+   * split into a second-level table as soon as single pages are needed,
+   * for example for copy on write.
+   */
   class Mem_big : public Moe::Dataspace_noncont
   {
   public:
@@ -236,6 +332,11 @@ namespace {
       L2_page_align      = 1UL << L2_page_shift,
       L2_mask_lobits     = L2_page_align - 1,
       L2_mask_hibits     = ~L2_mask_lobits,
+      L1_large           = L2_page_align >> 1,
+      L1_cnt_mask        = L1_large - 1,
+      Large_shift        = 2 * L4_PAGESHIFT
+                           - (sizeof(unsigned long) == 8 ? 3 : 2),
+      Large_size         = 1UL << Large_shift,
     };
 
     class L1
@@ -247,17 +348,109 @@ namespace {
       Page *l2() const throw() { return (Page*)(p & L2_mask_hibits); }
       Page &operator [] (unsigned long offs) throw()
       { return l2()[(offs >> L2_page_shift) & (entries2()-1)]; }
-      Page *operator * () const throw() { return l2(); }
-      unsigned long cnt() const throw() { return p & L2_mask_lobits; }
-      void inc() throw() { p = (p & L2_mask_hibits) | ((p+1) & L2_mask_lobits); }
-      void dec() throw() { p = (p & L2_mask_hibits) | ((p-1) & L2_mask_lobits); }
-      void set(void* _p) throw() { p = (unsigned long)_p; }
+      Page *operator * () const throw() { return large() ? 0 : l2(); }
+      unsigned long cnt() const throw() { return p & L1_cnt_mask; }
+      // saturates, the count must not wrap into the large flag or to 0
+      void inc() throw() { if (cnt() < L1_cnt_mask) ++p; }
+      void dec() throw() { p = (p & ~L1_cnt_mask) | ((p-1) & L1_cnt_mask); }
+      void set(void* _p, unsigned long cnt = 0) throw()
+      { p = (unsigned long)_p | cnt; }
+
+      bool large() const throw() { return p & L1_large; }
+      char *chunk() const throw() { return (char *)(p & L2_mask_hibits); }
+      void set_large(void *chunk) throw() { p = (unsigned long)chunk | L1_large; }
     };
 
     L1 &__p(unsigned long offs) const throw()
     { return ((L1*)pages)[(offs >> L2_page_shift) / entries2()]; }
-    
-  public:   
+
+    /// Back the empty large page around offs with a chunk if one is free.
+    char *alloc_large(unsigned long offs) const throw()
+    {
+      if (l4_trunc_size(offs, Large_shift) + Large_size > round_size())
+        return 0;
+
+      char *c = (char *)Page_alloc::_try_alloc(quota(), Large_size, Large_size);
+      if (!c)
+        return 0;
+
+      memset(c, 0, Large_size);
+      for (unsigned long o = 0; o < Large_size; o += page_size())
+        Moe::Pages::share(c + o);
+
+      __p(offs).set_large(c);
+      return c;
+    }
+
+    void free_large(L1 &l) const throw()
+    {
+      char *c = l.chunk();
+      l4_task_unmap(L4_BASE_TASK_CAP,
+                    l4_fpage((unsigned long)c, Large_shift, L4_FPAGE_RWX),
+                    L4_FP_OTHER_SPACES);
+
+      // large pages are never shared, they are split for copy on write
+      for (unsigned long o = 0; o < Large_size; o += page_size())
+        Moe::Pages::unshare(c + o);
+
+      Page_alloc::_free(quota(), c, Large_size);
+      l.set(0);
+    }
+
+    /// Track the pages of a large page in a second-level table.
+    void split(L1 &l) const
+    {
+      Page *t = (Page *)Page_alloc::_alloc(quota(), meta2_size(), meta2_size());
+      char *c = l.chunk();
+      for (unsigned long i = 0; i < entries2(); ++i)
+        t[i].set(c + i * page_size(), 0);
+
+      l.set(t, entries2());
+    }
+
+    /// Chunk backing the large page around offs, allocated if possible.
+    char *large_page(unsigned long offs) const throw()
+    {
+      L1 &l = __p(offs);
+      if (l.large())
+        return l.chunk();
+
+      return l.cnt() ? 0 : alloc_large(offs);
+    }
+
+    /**
+     * Largest block of the chunk c around offset that is no larger than
+     * 2^max_order and fits the receive window given by hot_spot, min and
+     * max (see Dataspace_cont::address()).
+     */
+    Address large_address(char *c, l4_addr_t offset, Ds_rw rw,
+                          l4_addr_t hot_spot, l4_addr_t min, l4_addr_t max,
+                          unsigned char max_order) const throw()
+    {
+      l4_addr_t adr = l4_addr_t(c) + (offset & (Large_size - 1));
+      unsigned char order = L4_PAGESHIFT;
+
+      min = l4_trunc_page(min);
+      while (order < max_order)
+        {
+          l4_addr_t map_base = l4_trunc_size(hot_spot, order + 1);
+          if (map_base < min || map_base + (1UL << (order + 1)) - 1 > max)
+            break;
+
+          if ((adr ^ hot_spot) & ~(~0UL << (order + 1)))
+            break;
+
+          ++order;
+        }
+
+      if (!is_writable())
+        rw = Read_only;
+
+      return Address(l4_trunc_size(adr, order), order, rw,
+                     adr & ~(~0UL << order));
+    }
+
+  public:
     unsigned long entries1() const throw()
     { return (num_pages() + entries2() - 1)/entries2(); }
 
@@ -273,35 +466,127 @@ namespace {
 
     ~Mem_big() throw()
     {
-      for (unsigned long i = 0; i < size(); i+=page_size())
+      for (unsigned long i = 0; i < size(); i += Large_size)
         {
-          free_page(page(i));
+          L1 &p = __p(i);
+
+          if (p.large())
+            free_large(p);
+          else if (*p)
+            {
+              for (unsigned long o = 0; o < Large_size && i + o < size();
+                   o += page_size())
+                free_page(p[i + o]);
+
+              Page_alloc::_free(quota(), *p, meta2_size());
+              p.set(0);
+            }
         }
 
-      for (unsigned long i = 0; i < size(); i+=page_size()*L1_page_align)
+      Page_alloc::_free(quota(), pages, meta1_size());
+    }
+
+    Address address(l4_addr_t offset,
+                    Ds_rw rw = Writable, l4_addr_t hot_spot = 0,
+                    l4_addr_t min = 0, l4_addr_t max = ~0) const
+    {
+      if (check_limit(offset))
+        if (char *c = large_page(offset))
+          return large_address(c, offset, rw, hot_spot, min, max,
+                               Large_shift);
+
+      return Dataspace_noncont::address(offset, rw, hot_spot, min, max);
+    }
+
+    Address address_around(l4_addr_t offset, Ds_rw rw,
+                           unsigned char order, l4_addr_t hot_spot,
+                           l4_addr_t min, l4_addr_t max) const
+    {
+      if (!check_limit(offset))
+        return Address(-L4_ERANGE);
+
+      // blocks never cross a large page
+      if (order > Large_shift)
+        order = Large_shift;
+
+      if (char *c = large_page(offset))
+        return large_address(c, offset, rw, hot_spot, min, max, order);
+
+      return Dataspace_noncont::address_around(offset, rw, order, hot_spot,
+                                               min, max);
+    }
+
+    void unmap(bool ro = false) const throw()
+    {
+      for (unsigned long i = 0; i < size(); i += Large_size)
         {
-          L1 &p = __p(i); 
+          L1 &p = __p(i);
+          if (p.large())
+            l4_task_unmap(L4_BASE_TASK_CAP,
+                          l4_fpage((unsigned long)p.chunk(), Large_shift,
+                                   ro ? L4_FPAGE_W : L4_FPAGE_RWX),
+                          L4_FP_OTHER_SPACES);
+          else if (*p)
+            for (unsigned long o = 0; o < Large_size && i + o < size();
+                 o += page_size())
+              unmap_page(p[i + o], ro);
+        }
+    }
 
-          if (*p)
-            Page_alloc::_free(quota(), *p, meta2_size());
-          p.set(0);
+    long clear(unsigned long offs, unsigned long _size) const throw()
+    {
+      if (!check_limit(offs))
+        return -L4_ERANGE;
+
+      unsigned long sz = _size = min(_size, round_size() - offs);
+      while (sz)
+        {
+          unsigned long n = min(l4_trunc_size(offs, Large_shift) + Large_size
+                                - offs, sz);
+          L1 &p = __p(offs);
+          if (!p.large())
+            Dataspace_noncont::clear(offs, n);
+          else if (n == Large_size)
+            free_large(p);
+          else
+            // keep the large page, just zero the range
+            Dataspace::clear(offs, n);
+
+          offs += n;
+          sz -= n;
         }
 
-      Page_alloc::_free(quota(), pages, meta1_size());
+      return _size;
     }
 
-    Page &page(unsigned long offs) const throw()
+    unsigned long next_page(unsigned long offs) const throw()
+    {
+      // skip large pages that are neither backed nor have a table
+      while (offs < round_size() && !__p(offs).large() && !__p(offs).cnt())
+        offs = l4_trunc_size(offs, Large_shift) + Large_size;
+
+      return offs;
+    }
+
+    Page &page(unsigned long offs) const
     {
       static Page invalid_page;
-      if (!__p(offs).cnt())
+      L1 &p = __p(offs);
+      if (p.large())
+        split(p);
+
+      if (!p.cnt())
         return invalid_page;
 
-      return __p(offs)[offs];
+      return p[offs];
     }
 
     Page &alloc_page(unsigned long offs) const
     {
       L1 &_p = __p(offs);
+      if (_p.large())
+        split(_p);
+
       if (!_p.cnt())
         {
           void *a = Page_alloc::_alloc(quota(), meta2_size(), meta2_size());
@@ -57,6 +57,9 @@ public:
   Address address(l4_addr_t offset,
                   Ds_rw rw = Writable, l4_addr_t hot_spot = 0,
                   l4_addr_t min = 0, l4_addr_t max = ~0) const;
+  Address address_around(l4_addr_t offset, Ds_rw rw,
+                         unsigned char order, l4_addr_t hot_spot,
+                         l4_addr_t min, l4_addr_t max) const;
   void unmap(bool ro = false) const throw();
 
   unsigned long page_shift() const throw() { return L4_LOG2_PAGESIZE; }
@@ -66,9 +69,14 @@ public:
   void *operator new (size_t size, Quota *q);
   void operator delete (void *m) throw();
 
-  virtual Page &page(unsigned long offs) const throw() = 0;
+  /// May have to allocate to track a large page by single pages.
+  virtual Page &page(unsigned long offs) const = 0;
   virtual Page &alloc_page(unsigned long offs) const = 0;
 
+  /// Offset of the first page at or after offs that may be populated.
+  virtual unsigned long next_page(unsigned long offs) const throw()
+  { return offs; }
+
   unsigned long num_pages() const throw()
   { return (size()+page_size()-1) / page_size(); }
 
@@ -233,6 +233,21 @@ __do_lazy_copy2(Dataspace_noncont *dst, unsigned long dst_offs,
   return true;
 }
 
+/// Share the populated pages of src with the empty dst.
+void
+__do_clone(Dataspace_noncont *dst, Dataspace_noncont const *src)
+{
+  unsigned long const pg_sz = dst->page_size();
+  unsigned long const end = dst->round_size();
+
+  for (unsigned long offs = src->next_page(0); offs < end;
+       offs = src->next_page(offs))
+    {
+      unsigned long dst_offs = offs;
+      __do_cow_copy2(dst, dst_offs, pg_sz, src, offs, pg_sz);
+    }
+}
+
 }; // and local annon namespace
 
 unsigned long 
@@ -260,4 +275,15 @@ Dataspace_util::copy(Dataspace *dst, unsigned long dst_offs,
   return __do_eager_copy(dst, dst_offs, src, src_offs, size);
 }
 
+void
+Dataspace_util::clone(Dataspace_noncont *dst, Dataspace const *src)
+{
+  Dataspace_noncont const *src_n = dynamic_cast<Dataspace_noncont const *>(src);
+  if (src_n && src->can_cow() && dst->can_cow()
+      && src->page_size() == dst->page_size())
+    __do_clone(dst, src_n);
+  else
+    copy(dst, 0, src, 0, src->size());
+}
+
 
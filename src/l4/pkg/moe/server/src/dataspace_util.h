@@ -10,10 +10,18 @@
 
 #include "dataspace.h"
 
+namespace Moe { class Dataspace_noncont; }
+
 namespace Dataspace_util
 {
   unsigned long copy(Moe::Dataspace *dst, unsigned long dst_offs,
       Moe::Dataspace const*src, unsigned long src_offs, unsigned long size);
 
+  /**
+   * \brief Copy all of src to the empty data space dst, sharing the
+   *        populated pages copy on write where possible.
+   */
+  void clone(Moe::Dataspace_noncont *dst, Moe::Dataspace const *src);
+
 };
 
@@ -25,6 +25,8 @@ Dbg::Dbg_bits Dbg::dbg_bits[] =
  {"namespace",     Dbg::Name_space},
  {"ns",            Dbg::Name_space},
  {"bfs",           Dbg::Boot_fs},
+ {"pagealloc",     Dbg::Page_alloc},
+ {"pa",            Dbg::Page_alloc},
  {"all",           ~0UL},
  {0,0}};
 
@@ -33,6 +33,7 @@ public:
     Parser     = 0x100,
     Boot_fs    = 0x200,
     Name_space = 0x400,
+    Page_alloc = 0x800,
   };
 
   struct Dbg_bits { char const *n; unsigned long bits; };
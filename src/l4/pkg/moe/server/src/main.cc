@@ -151,6 +151,8 @@ static void find_memory()
 
   info.printf("found %ld KByte free memory\n",
               Single_page_alloc_base::_avail() / 1024);
+  if (Dbg(Dbg::Page_alloc).is_active())
+    Single_page_alloc_base::_dump_stats();
 
   // adjust min_addr and max_addr to also contain boot modules
   L4::Kip::Mem_desc const *md  = L4::Kip::Mem_desc::first(kip());
@@ -368,6 +370,8 @@ static Dbg_bits const dbb[] =
    {"loader",     Dbg::Loader},
    {"ldr",        Dbg::Loader},
    {"ns",         Dbg::Name_space},
+   {"pagealloc",  Dbg::Page_alloc},
+   {"pa",         Dbg::Page_alloc},
    {"all",        ~0UL},
    {0,0}};
 
@@ -9,10 +9,12 @@
 #include <l4/util/util.h>
 
 #include <l4/cxx/iostream>
-#include <l4/cxx/list_alloc>
 #include <l4/cxx/exceptions>
 #include <l4/sys/kdebug.h>
 #include <gc.h>
+#include <cstdio>
+#include <cstring>
+#include "debug.h"
 #include "page_alloc.h"
 
 using L4::Out_of_memory;
@@ -23,42 +25,412 @@ enum { page_alloc_debug = 0 };
 unsigned page_alloc_debug = 0;
 #endif
 
-class LA : public cxx::List_alloc
+namespace {
+
+/**
+ * Binary buddy allocator for page-granular memory.
+ *
+ * Free blocks of 2^order pages are kept on one list per order and
+ * coalesced with their buddies when freed. A bitmap over the initial
+ * memory marks the first page of each free block, so that a buddy can be
+ * checked without touching memory that may be in use. The bitmap is
+ * taken from the initial memory with the first allocation, until then
+ * blocks are not coalesced.
+ *
+ * Single pages are freed into a small cache, which serves the next
+ * single-page allocations without touching the free lists.
+ */
+class Buddy_alloc
 {
-#if 0
 public:
-  ~LA()
-    {
-      L4::cout << "~LA(): avail = " << avail() << '\n';
-    }
-#endif
-#if 0
-public:
-  void *alloc(unsigned long size, unsigned long align)
+  enum
   {
-    L4::cout << "PA::alloc: " << L4::hex << size << '(' << align << ") -> \n";
-    void *p = cxx::List_alloc::alloc(size, align);
-    L4::cout << p << "\n";
-    return p;
+    Orders     = 20, ///< Block sizes from 1 to 2^(Orders - 1) pages
+    Cache_size = 32, ///< Capacity of the single-page cache
+    Cache_keep = 16, ///< Pages left in the cache when it is drained
+  };
+
+  struct Stats
+  {
+    unsigned long allocs;         ///< Successful allocations
+    unsigned long frees;          ///< Freed blocks and pages
+    unsigned long cache_hits;     ///< Single pages served from the cache
+    unsigned long merges;         ///< Buddies coalesced
+    unsigned long failed;         ///< Failed allocations
+    unsigned long gc_runs;        ///< Garbage collections to get memory
+    unsigned long blocks[Orders]; ///< Free blocks per order
+    unsigned long splits[Orders]; ///< Allocations by number of splits
+  };
+
+  Stats stats;
+
+  Buddy_alloc()
+  : _nonempty(0), _map(0), _map_base(0), _map_end(0),
+    _min(~0UL), _max(0), _avail(0), _cached(0)
+  {
+    memset(&stats, 0, sizeof(stats));
+    for (unsigned o = 0; o < Orders; ++o)
+      _free[o].next = _free[o].prev = &_free[o];
   }
-#endif
-#if 0
-public:
-  void free(void *p, unsigned long size)
+
+  void add(l4_addr_t start, l4_addr_t end);
+  void *alloc(unsigned long size, unsigned long align);
+  void free(l4_addr_t start, unsigned long size);
+
+  void *alloc_page()
   {
-    L4::cout << "free: " << p << '(' << size << ") -> "; 
-    cxx::List_alloc::free(p, size);
-    L4::cout << avail() << "\n";
+    if (_cached)
+      {
+        ++stats.cache_hits;
+        ++stats.allocs;
+        return (void *)_cache[--_cached];
+      }
+
+    return alloc(L4_PAGESIZE, 0);
   }
-#endif
+
+  void free_page(l4_addr_t p)
+  {
+    if (_cached == Cache_size)
+      drain(Cache_keep);
+
+    ++stats.frees;
+    _cache[_cached++] = p;
+  }
+
+  unsigned long avail() const
+  { return _avail + _cached * L4_PAGESIZE; }
+
+  void dump() const;
+
+private:
+  enum { Map_bits = sizeof(unsigned long) * 8 };
+
+  struct Free_block
+  {
+    Free_block *next;
+    Free_block *prev;
+    unsigned order;
+  };
+
+  static unsigned long block_size(unsigned order)
+  { return L4_PAGESIZE << order; }
+
+  /// Smallest order with at least the given number of pages.
+  static unsigned order_for(unsigned long pages)
+  { return pages <= 1 ? 0 : Map_bits - __builtin_clzl(pages - 1); }
+
+  bool in_map(l4_addr_t a) const
+  { return a >= _map_base && a < _map_end; }
+
+  bool is_marked(l4_addr_t a) const
+  {
+    if (!in_map(a))
+      return false;
+
+    unsigned long i = (a - _map_base) >> L4_PAGESHIFT;
+    return _map[i / Map_bits] & (1UL << (i % Map_bits));
+  }
+
+  void mark(l4_addr_t a, bool free)
+  {
+    if (!in_map(a))
+      return;
+
+    unsigned long i = (a - _map_base) >> L4_PAGESHIFT;
+    if (free)
+      _map[i / Map_bits] |= 1UL << (i % Map_bits);
+    else
+      _map[i / Map_bits] &= ~(1UL << (i % Map_bits));
+  }
+
+  void link(l4_addr_t a, unsigned order);
+  void unlink(Free_block *b);
+  l4_addr_t alloc_block(unsigned order);
+  void free_block(l4_addr_t a, unsigned order);
+  void free_range(l4_addr_t a, l4_addr_t end);
+  void drain(unsigned keep);
+  bool seal();
+
+  Free_block _free[Orders];
+  unsigned long _nonempty;
+  unsigned long *_map;
+  l4_addr_t _map_base, _map_end;
+  l4_addr_t _min, _max;
+  unsigned long _avail;
+  unsigned _cached;
+  l4_addr_t _cache[Cache_size];
 };
 
-static LA *page_alloc()
+void
+Buddy_alloc::link(l4_addr_t a, unsigned order)
+{
+  Free_block *b = (Free_block *)a;
+  Free_block *h = &_free[order];
+  b->order = order;
+  b->prev = h;
+  b->next = h->next;
+  h->next->prev = b;
+  h->next = b;
+  _nonempty |= 1UL << order;
+  ++stats.blocks[order];
+  mark(a, true);
+}
+
+void
+Buddy_alloc::unlink(Free_block *b)
+{
+  b->prev->next = b->next;
+  b->next->prev = b->prev;
+  if (_free[b->order].next == &_free[b->order])
+    _nonempty &= ~(1UL << b->order);
+  --stats.blocks[b->order];
+  mark((l4_addr_t)b, false);
+}
+
+l4_addr_t
+Buddy_alloc::alloc_block(unsigned order)
+{
+  unsigned long m = _nonempty >> order;
+  if (!m)
+    return 0;
+
+  unsigned o = order + __builtin_ctzl(m);
+  Free_block *b = _free[o].next;
+  unlink(b);
+
+  l4_addr_t a = (l4_addr_t)b;
+  ++stats.splits[o - order];
+  // keep the lower half, the upper halves go back to the free lists
+  while (o > order)
+    {
+      --o;
+      link(a + block_size(o), o);
+    }
+
+  _avail -= block_size(order);
+  return a;
+}
+
+void
+Buddy_alloc::free_block(l4_addr_t a, unsigned order)
 {
-  static LA pa;
+  if (is_marked(a))
+    {
+      L4::cerr << "Page_alloc(FATAL): trying to free memory that "
+                  "is already free: " << (void *)a << '\n';
+      return;
+    }
+
+  _avail += block_size(order);
+  while (order < Orders - 1)
+    {
+      l4_addr_t b = a ^ block_size(order);
+      if (!is_marked(b) || ((Free_block *)b)->order != order)
+        break;
+
+      unlink((Free_block *)b);
+      a &= ~block_size(order);
+      ++order;
+      ++stats.merges;
+    }
+
+  link(a, order);
+}
+
+/// Free the page-aligned range [a, end) as maximal aligned blocks.
+void
+Buddy_alloc::free_range(l4_addr_t a, l4_addr_t end)
+{
+  while (a < end)
+    {
+      unsigned o = Orders - 1;
+      if (a)
+        {
+          unsigned align = __builtin_ctzl(a) - L4_PAGESHIFT;
+          if (align < o)
+            o = align;
+        }
+
+      while (block_size(o) > end - a)
+        --o;
+
+      free_block(a, o);
+      a += block_size(o);
+    }
+}
+
+void
+Buddy_alloc::drain(unsigned keep)
+{
+  while (_cached > keep)
+    free_block(_cache[--_cached], 0);
+}
+
+/**
+ * Allocate the free-block bitmap for the initial memory and coalesce the
+ * initial blocks.
+ */
+bool
+Buddy_alloc::seal()
+{
+  if (_map)
+    return true;
+
+  if (_min >= _max)
+    return false;
+
+  unsigned long bits = (_max - _min) >> L4_PAGESHIFT;
+  unsigned long size = l4_round_page((bits + Map_bits - 1) / Map_bits
+                                     * sizeof(unsigned long));
+  unsigned order = order_for(size >> L4_PAGESHIFT);
+  if (order >= Orders)
+    return false;
+
+  l4_addr_t m = alloc_block(order);
+  if (!m)
+    return false;
+
+  free_range(m + size, m + block_size(order));
+  memset((void *)m, 0, size);
+
+  Free_block *all = 0;
+  for (unsigned o = 0; o < Orders; ++o)
+    while (_free[o].next != &_free[o])
+      {
+        Free_block *b = _free[o].next;
+        unlink(b);
+        b->next = all;
+        all = b;
+      }
+
+  _map = (unsigned long *)m;
+  _map_base = _min;
+  _map_end = _max;
+  _avail = 0;
+
+  while (all)
+    {
+      Free_block *n = all->next;
+      free_block((l4_addr_t)all, all->order);
+      all = n;
+    }
+
+  return true;
+}
+
+void
+Buddy_alloc::add(l4_addr_t start, l4_addr_t end)
+{
+  start = l4_round_page(start);
+  end = l4_trunc_page(end);
+  if (start >= end)
+    return;
+
+  // memory added later is not covered by the bitmap and never coalesced
+  if (!_map)
+    {
+      if (start < _min)
+        _min = start;
+      if (end > _max)
+        _max = end;
+    }
+
+  free_range(start, end);
+}
+
+void *
+Buddy_alloc::alloc(unsigned long size, unsigned long align)
+{
+  if (!seal())
+    {
+      ++stats.failed;
+      return 0;
+    }
+
+  size = l4_round_page(size);
+  unsigned order = order_for(size >> L4_PAGESHIFT);
+  if (align > L4_PAGESIZE)
+    {
+      unsigned a = order_for(align >> L4_PAGESHIFT);
+      if (a > order)
+        order = a;
+    }
+
+  if (order >= Orders)
+    {
+      ++stats.failed;
+      return 0;
+    }
+
+  l4_addr_t r = alloc_block(order);
+  if (!r && _cached)
+    {
+      drain(0);
+      r = alloc_block(order);
+    }
+
+  if (!r)
+    {
+      ++stats.failed;
+      return 0;
+    }
+
+  // give back the unused tail of the block
+  free_range(r + size, r + block_size(order));
+  ++stats.allocs;
+  return (void *)r;
+}
+
+void
+Buddy_alloc::free(l4_addr_t start, unsigned long size)
+{
+  ++stats.frees;
+  free_range(start, start + l4_round_page(size));
+}
+
+void
+Buddy_alloc::dump() const
+{
+  unsigned long largest = 0;
+  for (unsigned o = 0; o < Orders; ++o)
+    if (stats.blocks[o])
+      largest = 1UL << o;
+
+  // share of the free pages outside of the largest free block
+  unsigned long pages = avail() >> L4_PAGESHIFT;
+  printf("MOE: page_alloc: avail=%lu Byte, cached=%u pages, "
+         "largest block=%lu Byte, fragmentation=%lu%%\n",
+         avail(), _cached, largest << L4_PAGESHIFT,
+         pages ? 100 - largest * 100 / pages : 0);
+  printf("MOE: page_alloc: allocs=%lu frees=%lu cache hits=%lu merges=%lu "
+         "failed=%lu gc=%lu\n",
+         stats.allocs, stats.frees, stats.cache_hits, stats.merges,
+         stats.failed, stats.gc_runs);
+  printf("MOE: page_alloc: free blocks per order:");
+  for (unsigned o = 0; o < Orders; ++o)
+    printf(" %lu", stats.blocks[o]);
+  printf("\nMOE: page_alloc: allocations by splits:");
+  for (unsigned o = 0; o < Orders; ++o)
+    printf(" %lu", stats.splits[o]);
+  printf("\n");
+}
+
+}
+
+static Buddy_alloc *page_alloc()
+{
+  static Buddy_alloc pa;
   return &pa;
 }
 
+static void gc_for_memory()
+{
+  ++page_alloc()->stats.gc_runs;
+  Dbg(Dbg::Page_alloc, "pa").printf("out of memory, collecting garbage\n");
+  GC_gcollect_and_unmap();
+}
+
 Single_page_alloc_base::Single_page_alloc_base()
 {}
 
@@ -67,13 +439,18 @@ unsigned long Single_page_alloc_base::_avail()
   return page_alloc()->avail();
 }
 
+void Single_page_alloc_base::_dump_stats()
+{
+  page_alloc()->dump();
+}
+
 void *Single_page_alloc_base::_alloc(Nothrow)
 {
-  void *ret = page_alloc()->alloc(L4_PAGESIZE, L4_PAGESIZE);
+  void *ret = page_alloc()->alloc_page();
   if (!ret)
     {
-      GC_gcollect_and_unmap();
-      ret = page_alloc()->alloc(L4_PAGESIZE, L4_PAGESIZE);
+      gc_for_memory();
+      ret = page_alloc()->alloc_page();
     }
 
   if (page_alloc_debug)
@@ -85,7 +462,7 @@ void Single_page_alloc_base::_free(void *p)
 {
   if (page_alloc_debug)
     L4::cout << "pa(" << __builtin_return_address(0) << "): free(PAGE) @" << p << '\n';
-  page_alloc()->free(p, L4_PAGESIZE); 
+  page_alloc()->free_page((l4_addr_t)p);
 }
 
 void *Single_page_alloc_base::_alloc(Nothrow, unsigned long size, unsigned long align)
@@ -93,7 +470,7 @@ void *Single_page_alloc_base::_alloc(Nothrow, unsigned long size, unsigned long
   void *ret = page_alloc()->alloc(size, align);
   if (!ret)
     {
-      GC_gcollect_and_unmap();
+      gc_for_memory();
       ret = page_alloc()->alloc(size, align);
     }
   if (page_alloc_debug)
@@ -101,9 +478,22 @@ void *Single_page_alloc_base::_alloc(Nothrow, unsigned long size, unsigned long
   return ret;
 }
 
+void *Single_page_alloc_base::_try_alloc(unsigned long size, unsigned long align) throw()
+{
+  void *ret = page_alloc()->alloc(size, align);
+  if (ret)
+    GC_remove_roots(ret, (char*)ret + size);
+  if (page_alloc_debug)
+    L4::cout << "pa(" << __builtin_return_address(0) << "): try_alloc(" << size << ") @" << ret << '\n';
+  return ret;
+}
+
 void Single_page_alloc_base::_free(void *p, unsigned long size, bool initial_mem)
 {
   if (page_alloc_debug)
     L4::cout << "pa(" << __builtin_return_address(0) << "): free(" << size << ") @" << p << '\n';
-  page_alloc()->free(p, size, initial_mem);
+  if (initial_mem)
+    page_alloc()->add((l4_addr_t)p, (l4_addr_t)p + size);
+  else
+    page_alloc()->free((l4_addr_t)p, size);
 }
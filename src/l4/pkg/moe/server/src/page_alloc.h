@@ -43,8 +43,11 @@ public:
     GC_remove_roots(r, (char*)r + size);
     return r;
   }
+  /// Allocate without collecting garbage if no memory is free.
+  static void *_try_alloc(unsigned long size, unsigned long align = 0) throw();
   static void _free(void *p, unsigned long size, bool initial_mem = false);
   static unsigned long _avail();
+  static void _dump_stats();
 };
 
 template<typename A>
@@ -183,6 +183,18 @@ struct Q_alloc_static
     return g.done(Alloc::_alloc(size, align));
   }
 
+  /// Allocate only if quota and memory are available right away.
+  static void *_try_alloc(Quota *q, unsigned long size, unsigned long align) throw()
+  {
+    if (q->limit() && (size > q->limit() || q->used() > q->limit() - size))
+      return 0;
+
+    void *r = Alloc::_try_alloc(size, align);
+    if (r)
+      q->alloc(size);
+    return r;
+  }
+
   static void _free(Quota *q, void *p, unsigned long size) throw()
   {
     Alloc::_free(p, size);
@@ -45,7 +45,7 @@ Region_map::Region_map()
 
 int Region_ops::map(Region_handler const *h, l4_addr_t adr,
                     L4Re::Util::Region const &r, bool writable,
-                    L4::Ipc::Snd_fpage *result)
+                    unsigned char around, L4::Ipc::Snd_fpage *result)
 {
   l4_addr_t offs = adr - r.start();
   offs = l4_trunc_page(offs);
@@ -56,8 +56,19 @@ int Region_ops::map(Region_handler const *h, l4_addr_t adr,
     Dbg(Dbg::Warn).printf("WARNING: "
          "Writable mapping request on read-only region at %lx!\n",
          adr);
-  *result = L4::Ipc::Snd_fpage(h->memory()->address(offs + h->offset(), rw, adr,
-                          r.start(), r.end()).fp(), offs + r.start());
+  // the block must fit into the region, with the same alignment
+  Moe::Dataspace::Address a(-L4_ENOENT);
+  if (around > L4_PAGESHIFT
+      && l4_trunc_size(adr, around) >= r.start()
+      && l4_trunc_size(adr, around) + (1UL << around) - 1 <= r.end()
+      && !(h->offset() & ((1UL << around) - 1))
+      && !(r.start() & ((1UL << around) - 1)))
+    a = h->memory()->address_around(offs + h->offset(), rw, around,
+                                    adr, r.start(), r.end());
+  if (a.is_nil())
+    a = h->memory()->address(offs + h->offset(), rw, adr, r.start(), r.end());
+
+  *result = L4::Ipc::Snd_fpage(a.fp(), offs + r.start());
 
   return L4_EOK;
 }
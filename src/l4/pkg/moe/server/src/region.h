@@ -28,7 +28,7 @@ public:
   typedef L4::Ipc::Snd_fpage Map_result;
   static int map(Region_handler const *h, l4_addr_t adr,
                  L4Re::Util::Region const &r, bool writable,
-                 L4::Ipc::Snd_fpage *result);
+                 unsigned char around, L4::Ipc::Snd_fpage *result);
   static void unmap(Region_handler const * /*h*/, l4_addr_t /*vaddr*/,
                     l4_addr_t /*offs*/, unsigned long /*size*/)
   {}